@@ -20,15 +20,26 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/xxhash.h"
 
 #include <memory>
 #include <vector>
 #include <sstream>
 #include <sys/resource.h>
 #include <iomanip>
+#include <thread>
+#include <atomic>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
 
 #include "Analyzer.h"
 #include "CallGraph.h"
+#include "Summary.h"
+#include "SummaryCallGraph.h"
 #include "Config.h"
 
 
@@ -55,15 +66,102 @@ cl::opt<int> TyPM(
 	cl::NotHidden, cl::init(1));
 GlobalContext GlobalCtx;
 
+vector<Function *> FuncIDMap::Funcs;
+DenseMap<Function *, uint32_t> FuncIDMap::IDs;
+
+uint32_t FuncIDMap::getID(Function *F) {
+	auto It = IDs.insert(make_pair(F, (uint32_t)Funcs.size()));
+	if (It.second)
+		Funcs.push_back(F);
+	return It.first->second;
+}
+
 cl::opt<int> PHASE(
     "phase",
 	cl::desc("How many iterations? \
 		targets"),
 	cl::NotHidden, cl::init(2));
 
+cl::opt<bool> Pipeline(
+    "pipeline",
+	cl::desc("Overlap reading function bodies with the initialization \
+		of modules"),
+	cl::NotHidden, cl::init(false));
+
+cl::opt<unsigned> LoadThreads(
+    "load-threads",
+	cl::desc("Number of threads for parsing the input bitcode files"),
+	cl::NotHidden, cl::init(1));
+
+cl::opt<bool> SharedContext(
+    "shared-context",
+	cl::desc("Load all modules into a single LLVMContext, so that \
+		identical types of different modules are the same Type \
+		(files are parsed in full, one after another)"),
+	cl::NotHidden, cl::init(false));
+
+cl::opt<unsigned> MaxResidentModules(
+    "max-resident-modules",
+	cl::desc("Analyze module summaries instead of the modules, keeping \
+		at most this many modules in memory (0: keep all modules)"),
+	cl::NotHidden, cl::init(0));
+
+cl::opt<std::string> EmitSummary(
+    "emit-summary",
+	cl::desc("Write the summary of each module into this directory, \
+		for -from-summaries, and exit"),
+	cl::NotHidden, cl::init(""));
+
+cl::opt<std::string> CriticalStructs(
+    "critical-structs",
+	cl::desc("File of target types (default: configs/critical-structs)"),
+	cl::NotHidden, cl::init(""));
+
+cl::opt<std::string> Sweep(
+    "sweep",
+	cl::desc("Run the configurations in this file, one per line, as \
+		\"<output file> [-mlta=N] [-typm=N] [-phase=N] \
+		[-critical-structs=FILE]\", loading the modules only once"),
+	cl::NotHidden, cl::init(""));
+
+cl::opt<unsigned> SweepJobs(
+    "sweep-jobs",
+	cl::desc("Number of configurations of -sweep to run at a time"),
+	cl::NotHidden, cl::init(1));
+
+cl::opt<std::string> Shard(
+    "shard",
+	cl::desc("With -emit-summary, only summarize the i-th of N equal \
+		parts of the input files, given as i/N"),
+	cl::NotHidden, cl::init(""));
+
+cl::opt<bool> Merge(
+    "merge",
+	cl::desc("The input is a directory of summaries written by \
+		-emit-summary with -shard; analyze all shards together"),
+	cl::NotHidden, cl::init(false));
+
+cl::opt<std::string> SummaryCache(
+    "summary-cache",
+	cl::desc("Reuse the summaries of unchanged modules from this \
+		directory, and add new ones to it"),
+	cl::NotHidden, cl::init(""));
+
+cl::opt<bool> FromSummaries(
+    "from-summaries",
+	cl::desc("The input files are summary files written by \
+		-emit-summary"),
+	cl::NotHidden, cl::init(false));
+
 
 void IterativeModulePass::run(ModuleList &modules) {
 
+	runInitialization(modules);
+	runIterations(modules);
+}
+
+void IterativeModulePass::runInitialization(ModuleList &modules) {
+
 	ModuleList::iterator i, e;
 	OP << "[" << ID << "] Initializing " << modules.size() << " modules ";
 	bool again = true;
@@ -75,7 +173,12 @@ void IterativeModulePass::run(ModuleList &modules) {
 		}
 	}
 	OP << "\n";
+}
+
+void IterativeModulePass::runIterations(ModuleList &modules) {
 
+	ModuleList::iterator i, e;
+	bool again;
 	unsigned iter = 0, changed = 1;
 	while (changed) {
 		++iter;
@@ -110,11 +213,41 @@ void IterativeModulePass::run(ModuleList &modules) {
 	OP << "[" << ID << "] Done!\n\n";
 }
 
+ModulePipeline::~ModulePipeline() {
+	for (auto &T : Workers)
+		T.join();
+}
+
+void ModulePipeline::start(unsigned NumThreads) {
+
+	auto Worker = [this]() {
+		unsigned i;
+		while ((i = NextModule++) < Modules.size()) {
+			Module *M = Modules[i].first;
+			materializeModule(M);
+
+			lock_guard<mutex> Guard(Lock);
+			ReadyModules.insert(M);
+			Ready.notify_all();
+		}
+	};
+
+	NumThreads = std::max(1u, std::min(NumThreads, 
+				(unsigned)Modules.size()));
+	for (unsigned t = 0; t < NumThreads; ++t)
+		Workers.push_back(thread(Worker));
+}
+
+void ModulePipeline::waitForModule(Module *M) {
+	unique_lock<mutex> Guard(Lock);
+	Ready.wait(Guard, [&]() { return ReadyModules.count(M) > 0; });
+}
+
 void PrintResults(GlobalContext *GCtx) {
 
 	int TotalTargets = 0;
 	for (auto IC : GCtx->IndirectCallInsts) {
-		TotalTargets += GCtx->Callees[IC].size();
+		TotalTargets += GCtx->getCallees(IC).size();
 	}
 	float AveIndirectTargets = 0.0;
 	if (GCtx->NumValidIndirectCalls)
@@ -122,10 +255,10 @@ void PrintResults(GlobalContext *GCtx) {
 			(float)GCtx->NumIndirectCallTargets/GCtx->IndirectCallInsts.size();
 
 	int totalsize = 0;
-	for (auto &curEle: GCtx->Callees) {
-		if (curEle.first->isIndirectCall()) {
-			totalsize += curEle.second.size();
-		}
+	CSRCallGraph &CG = GCtx->FinalCG;
+	for (uint32_t C = 0; C < CG.getNumCallSites(); ++C) {
+		if (CG.getCallSite(C)->isIndirectCall())
+			totalsize += CG.getCallees(C).size();
 	}
 	OP << "\n@@ Total number of final callees: " << totalsize << "\n";
 
@@ -142,6 +275,490 @@ void PrintResults(GlobalContext *GCtx) {
 
 }
 
+// Parse the given input files, each into its own LLVMContext.
+// Workers pick files by index, and Loaded keeps the order of Files
+// so that the analysis stays deterministic. With -pipeline, only
+// globals, declarations and types are read here; the function bodies
+// are read in the background, see ModulePipeline.
+void ParseModules(const vector<unsigned> &Files, vector<Module *> &Loaded) {
+
+	unsigned NumFiles = Files.size();
+	Loaded.assign(NumFiles, NULL);
+	atomic<unsigned> NextFile(0);
+
+	auto Worker = [&]() {
+		unsigned i;
+		while ((i = NextFile++) < NumFiles) {
+			LLVMContext *LLVMCtx = new LLVMContext();
+			SMDiagnostic Err;
+			string &FileName = InputFilenames[Files[i]];
+			std::unique_ptr<Module> M = Pipeline ?
+				getLazyIRFileModule(FileName, Err, *LLVMCtx) :
+				parseIRFile(FileName, Err, *LLVMCtx);
+			if (M == NULL) {
+				delete LLVMCtx;
+				continue;
+			}
+			Loaded[i] = M.release();
+		}
+	};
+
+	unsigned NumThreads = std::min((unsigned)LoadThreads, NumFiles);
+	vector<thread> Workers;
+	for (unsigned t = 1; t < NumThreads; ++t)
+		Workers.push_back(thread(Worker));
+	// The main thread is a worker as well
+	Worker();
+	for (auto &T : Workers)
+		T.join();
+}
+
+// Parse the input files, one after another, into a single LLVMContext.
+// The context renames a struct whose name is taken by an earlier
+// module; the renamed structs are recorded so that the type hashes do
+// not change, see structName(). Modules are parsed in full, as
+// function bodies may use structs of their own.
+void ParseModulesShared(vector<Module *> &Loaded) {
+
+	LLVMContext *LLVMCtx = new LLVMContext();
+	for (unsigned i = 0; i < InputFilenames.size(); ++i) {
+		SMDiagnostic Err;
+		std::unique_ptr<Module> M =
+			parseIRFile(InputFilenames[i], Err, *LLVMCtx);
+		if (M == NULL) {
+			Loaded.push_back(NULL);
+			continue;
+		}
+		detachStructNames(M.get());
+		Loaded.push_back(M.release());
+	}
+	restoreStructNames();
+}
+
+void LoadModules(GlobalContext *GCtx, const char *Prog) {
+
+	unsigned NumFiles = InputFilenames.size();
+	vector<Module *> Loaded;
+	if (SharedContext)
+		ParseModulesShared(Loaded);
+	else {
+		GCtx->NumThreads = LoadThreads;
+		vector<unsigned> Files;
+		for (unsigned i = 0; i < NumFiles; ++i)
+			Files.push_back(i);
+		ParseModules(Files, Loaded);
+	}
+
+	for (unsigned i = 0; i < NumFiles; ++i) {
+
+		if (Loaded[i] == NULL) {
+			OP << Prog << ": error loading file '"
+				<< InputFilenames[i] << "'\n";
+			continue;
+		}
+
+		Module *Module = Loaded[i];
+		StringRef MName = StringRef(strdup(InputFilenames[i].data()));
+		GCtx->ModuleIDs[Module] = GCtx->Modules.size();
+		GCtx->Modules.push_back(std::make_pair(Module, MName));
+	}
+}
+
+// The cache file of an input file for -summary-cache, named after the
+// hash of the bitcode and the hash of the configuration; empty if the
+// file cannot be read
+string GetSummaryCachePath(string FileName, uint64_t ConfigHash) {
+
+	ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+		MemoryBuffer::getFile(FileName);
+	if (!MBOrErr)
+		return "";
+
+	string Key;
+	raw_string_ostream KeyOS(Key);
+	KeyOS << format_hex_no_prefix(xxHash64((*MBOrErr)->getBuffer()), 16)
+		<< "-" << format_hex_no_prefix(ConfigHash, 16) << ".tsum";
+	KeyOS.flush();
+
+	SmallString<256> Path(SummaryCache);
+	sys::path::append(Path, Key);
+	return Path.str().str();
+}
+
+// With -max-resident-modules=K, the input files are parsed K at a
+// time and summarized in the command-line order. Each module and its
+// LLVMContext are freed as soon as the module is summarized, so at
+// most K modules are in memory.
+// With -summary-cache, modules whose summary is in the cache are not
+// parsed at all, and new summaries are added to the cache.
+void SummarizeModules(GlobalContext *GCtx, 
+		vector<ModuleSummary> &Summaries, const char *Prog) {
+
+	SummaryBuilder Builder(GCtx);
+	unsigned NumFiles = InputFilenames.size();
+	vector<ModuleSummary> FileSummaries(NumFiles);
+	vector<bool> Summarized(NumFiles, false);
+
+	// Files to summarize
+	vector<unsigned> Files;
+	vector<string> CachePaths(NumFiles);
+	if (SummaryCache != "") {
+		if (sys::fs::create_directories(SummaryCache))
+			OP << Prog << ": cannot create directory '"
+				<< SummaryCache << "'\n";
+		uint64_t ConfigHash = Builder.getConfigHash();
+		for (unsigned i = 0; i < NumFiles; ++i) {
+			CachePaths[i] = GetSummaryCachePath(InputFilenames[i],
+					ConfigHash);
+			string Err;
+			if (CachePaths[i] != "" &&
+					readModuleSummary(CachePaths[i], FileSummaries[i], Err)) {
+				// The same bitcode may be cached under another path
+				FileSummaries[i].Name = InputFilenames[i];
+				Summarized[i] = true;
+			}
+			else
+				Files.push_back(i);
+		}
+		OP << "Summary cache: " << NumFiles - Files.size() << " hit(s), "
+			<< Files.size() << " miss(es)\n";
+	}
+	else {
+		for (unsigned i = 0; i < NumFiles; ++i)
+			Files.push_back(i);
+	}
+
+	unsigned Window = MaxResidentModules ? MaxResidentModules : NumFiles;
+	for (unsigned Begin = 0; Begin < Files.size(); Begin += Window) {
+
+		unsigned End = std::min((unsigned)Files.size(), Begin + Window);
+		vector<unsigned> WindowFiles(Files.begin() + Begin,
+				Files.begin() + End);
+		vector<Module *> Loaded;
+		ParseModules(WindowFiles, Loaded);
+
+		for (unsigned j = 0; j < WindowFiles.size(); ++j) {
+
+			unsigned i = WindowFiles[j];
+			Module *M = Loaded[j];
+			if (M == NULL) {
+				OP << Prog << ": error loading file '"
+					<< InputFilenames[i] << "'\n";
+				continue;
+			}
+
+			Builder.summarize(M, FileSummaries[i]);
+			Summarized[i] = true;
+
+			LLVMContext *LLVMCtx = &M->getContext();
+			delete M;
+			delete LLVMCtx;
+
+			// Write to a private file first, as other runs may share
+			// the cache
+			if (CachePaths[i] != "") {
+				string TmpPath = CachePaths[i] + ".tmp" +
+					to_string(sys::Process::getProcessId());
+				if (!writeModuleSummary(FileSummaries[i], TmpPath) ||
+						sys::fs::rename(TmpPath, CachePaths[i]))
+					sys::fs::remove(TmpPath);
+			}
+		}
+	}
+
+	for (unsigned i = 0; i < NumFiles; ++i) {
+		if (Summarized[i])
+			Summaries.push_back(std::move(FileSummaries[i]));
+	}
+}
+
+// Write one summary file per module into Dir, and the list of the
+// files, in the order of the input files, into Dir/ListName. The list
+// of an unsharded run, Dir/summaries.list, can be passed to
+// -from-summaries as @Dir/summaries.list
+bool EmitSummaries(vector<ModuleSummary> &Summaries, string Dir,
+		string ListName, const char *Prog) {
+
+	if (sys::fs::create_directories(Dir)) {
+		OP << Prog << ": cannot create directory '" << Dir << "'\n";
+		return false;
+	}
+
+	string List;
+	set<string> FileNames;
+	for (ModuleSummary &S : Summaries) {
+
+		// Flatten the path of the module into a file name
+		string Name = S.Name;
+		while (Name.size() > 0 && (Name[0] == '.' || Name[0] == '/'))
+			Name.erase(0, 1);
+		std::replace(Name.begin(), Name.end(), '/', '_');
+		string FileName = Name + ".tsum";
+		for (unsigned i = 1; FileNames.count(FileName); ++i)
+			FileName = Name + "." + to_string(i) + ".tsum";
+		FileNames.insert(FileName);
+
+		SmallString<256> Path(Dir);
+		sys::path::append(Path, FileName);
+		if (!writeModuleSummary(S, Path.str().str())) {
+			OP << Prog << ": error writing file '" << Path << "'\n";
+			return false;
+		}
+		List += Path.str().str() + "\n";
+	}
+
+	SmallString<256> ListPath(Dir);
+	sys::path::append(ListPath, ListName);
+	std::error_code EC;
+	raw_fd_ostream ListOS(ListPath, EC, sys::fs::OF_Text);
+	if (EC) {
+		OP << Prog << ": error writing file '" << ListPath << "'\n";
+		return false;
+	}
+	ListOS << List;
+
+	OP << "Wrote " << Summaries.size() << " summaries to " << Dir << "\n";
+	return true;
+}
+
+void LoadSummaries(vector<string> &Paths, 
+		vector<ModuleSummary> &Summaries, const char *Prog) {
+
+	for (string &Path : Paths) {
+
+		ModuleSummary S;
+		string Err;
+		if (!readModuleSummary(Path, S, Err)) {
+			OP << Prog << ": error loading file '"
+				<< Path << "': " << Err << "\n";
+			continue;
+		}
+		Summaries.push_back(std::move(S));
+	}
+}
+
+// Collect the summary files of all shards in Dir, in the order of the
+// shards, from the lists summaries.<i>-of-<N>.list
+bool LoadShardLists(string Dir, vector<string> &Paths, 
+		const char *Prog) {
+
+	map<unsigned, string> ShardLists;
+	unsigned NumShards = 0;
+	std::error_code EC;
+	for (sys::fs::directory_iterator DI(Dir, EC), DE; 
+			DI != DE && !EC; DI.increment(EC)) {
+
+		string FileName = sys::path::filename(DI->path()).str();
+		unsigned i, N;
+		char Tail[8];
+		if (sscanf(FileName.c_str(), "summaries.%u-of-%u.%7s", 
+					&i, &N, Tail) != 3 || strcmp(Tail, "list"))
+			continue;
+		if ((NumShards && N != NumShards) || i >= N) {
+			OP << Prog << ": inconsistent shard list '" 
+				<< DI->path() << "'\n";
+			return false;
+		}
+		NumShards = N;
+		ShardLists[i] = DI->path();
+	}
+	if (EC || NumShards == 0) {
+		OP << Prog << ": no shard lists in '" << Dir << "'\n";
+		return false;
+	}
+	if (ShardLists.size() != NumShards) {
+		OP << Prog << ": only " << ShardLists.size() << " of " 
+			<< NumShards << " shards in '" << Dir << "'\n";
+		return false;
+	}
+
+	for (auto &SL : ShardLists) {
+		ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+			MemoryBuffer::getFile(SL.second);
+		if (!MBOrErr) {
+			OP << Prog << ": error loading file '" << SL.second << "'\n";
+			return false;
+		}
+		SmallVector<StringRef, 64> Lines;
+		(*MBOrErr)->getBuffer().split(Lines, '\n', -1, false);
+		for (StringRef Line : Lines)
+			Paths.push_back(Line.str());
+	}
+	return true;
+}
+
+// A configuration of -sweep
+struct SweepPoint {
+	string Output;
+	int MLTALevel;
+	int TyPMLevel;
+	int Phase;
+	string TargetTypesFile;
+};
+
+void SetConfig(int MLTALevel, int TyPMLevel, int Phase, 
+		string TargetTypesFile) {
+
+	ENABLE_MLTA = MLTALevel;
+	ENABLE_TYDM = TyPMLevel;
+	MAX_PHASE_CG = Phase;
+	if (!ENABLE_TYDM)
+		MAX_PHASE_CG = 1;
+	TARGET_TYPES_FILE = TargetTypesFile;
+}
+
+bool LoadSweepPoints(string File, vector<SweepPoint> &Points, 
+		const char *Prog) {
+
+	ifstream SweepFile(File);
+	if (!SweepFile.is_open()) {
+		OP << Prog << ": cannot open '" << File << "'\n";
+		return false;
+	}
+
+	string Line;
+	unsigned LineNo = 0;
+	while (getline(SweepFile, Line)) {
+		++LineNo;
+		istringstream Tokens(Line);
+		string Token;
+		if (!(Tokens >> Token) || Token[0] == '#')
+			continue;
+
+		// Options not given are taken from the command line
+		SweepPoint P = {Token, MLTA, TyPM, PHASE, CriticalStructs};
+		while (Tokens >> Token) {
+			StringRef Name, Value;
+			std::tie(Name, Value) = StringRef(Token).ltrim('-').split('=');
+			bool Bad = false;
+			if (Name == "mlta")
+				Bad = Value.getAsInteger(10, P.MLTALevel);
+			else if (Name == "typm")
+				Bad = Value.getAsInteger(10, P.TyPMLevel);
+			else if (Name == "phase")
+				Bad = Value.getAsInteger(10, P.Phase);
+			else if (Name == "critical-structs")
+				P.TargetTypesFile = Value.str();
+			else
+				Bad = true;
+			if (Bad) {
+				OP << Prog << ": " << File << ":" << LineNo 
+					<< ": bad option '" << Token << "'\n";
+				return false;
+			}
+		}
+		Points.push_back(P);
+	}
+	return true;
+}
+
+// Wait for a child process; returns false if it failed
+bool WaitChild(pid_t Pid) {
+
+	int Status;
+	if (waitpid(Pid, &Status, 0) < 0)
+		return false;
+	return WIFEXITED(Status) && WEXITSTATUS(Status) == 0;
+}
+
+// Initialize the modules for a group of configurations, and run each
+// of them in a child process, which starts from a copy-on-write
+// snapshot of the initialized state and prints into its own file
+int RunSweepGroup(vector<SweepPoint> &Points, vector<unsigned> &Group,
+		const char *Prog) {
+
+	SweepPoint &First = Points[Group.front()];
+	SetConfig(First.MLTALevel, First.TyPMLevel, First.Phase, 
+			First.TargetTypesFile);
+
+	CallGraphPass CGPass(&GlobalCtx);
+	CGPass.runInitialization(GlobalCtx.Modules);
+
+	bool Failed = false;
+	vector<pid_t> Running;
+	for (unsigned i : Group) {
+
+		SweepPoint &P = Points[i];
+		if (Running.size() >= std::max((unsigned)SweepJobs, 1U)) {
+			Failed |= !WaitChild(Running.front());
+			Running.erase(Running.begin());
+		}
+
+		OP << "[Sweep] " << P.Output << ": -mlta=" << P.MLTALevel 
+			<< " -typm=" << P.TyPMLevel << " -phase=" << P.Phase << "\n";
+
+		cout.flush();
+		pid_t Pid = fork();
+		if (Pid < 0) {
+			OP << Prog << ": cannot fork for '" << P.Output << "'\n";
+			Failed = true;
+			continue;
+		}
+		if (Pid == 0) {
+			int FD = open(P.Output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 
+					0644);
+			if (FD < 0) {
+				OP << Prog << ": cannot open '" << P.Output << "'\n";
+				_exit(1);
+			}
+			// Results are printed to both stdout and stderr
+			dup2(FD, STDOUT_FILENO);
+			dup2(FD, STDERR_FILENO);
+			close(FD);
+
+			SetConfig(P.MLTALevel, P.TyPMLevel, P.Phase, 
+					P.TargetTypesFile);
+			CGPass.runIterations(GlobalCtx.Modules);
+			PrintResults(&GlobalCtx);
+			cout.flush();
+			OP.flush();
+			_exit(0);
+		}
+		Running.push_back(Pid);
+	}
+
+	for (pid_t Pid : Running)
+		Failed |= !WaitChild(Pid);
+
+	return Failed ? 1 : 0;
+}
+
+// With -sweep, the modules are loaded once. The initialization only
+// depends on whether MLTA is enabled (-mlta > 1) and on the target
+// types, so it is done once for each group of configurations that
+// agree on these, in a child process, see RunSweepGroup().
+int RunSweep(vector<SweepPoint> &Points, const char *Prog) {
+
+	vector<pair<pair<bool, string>, vector<unsigned>>> Groups;
+	for (unsigned i = 0; i < Points.size(); ++i) {
+		auto Key = make_pair(Points[i].MLTALevel > 1, 
+				Points[i].TargetTypesFile);
+		auto It = find_if(Groups.begin(), Groups.end(), 
+				[&](pair<pair<bool, string>, vector<unsigned>> &G) {
+					return G.first == Key; });
+		if (It == Groups.end()) {
+			Groups.push_back(make_pair(Key, vector<unsigned>()));
+			It = Groups.end() - 1;
+		}
+		It->second.push_back(i);
+	}
+
+	bool Failed = false;
+	for (auto &G : Groups) {
+		cout.flush();
+		pid_t Pid = fork();
+		if (Pid < 0) {
+			OP << Prog << ": cannot fork\n";
+			return 1;
+		}
+		if (Pid == 0)
+			_exit(RunSweepGroup(Points, G.second, Prog));
+		Failed |= !WaitChild(Pid);
+	}
+
+	return Failed ? 1 : 0;
+}
+
 int main(int argc, char **argv) {
 
 	// Print a stack trace if we signal out.
@@ -151,41 +768,108 @@ int main(int argc, char **argv) {
 	llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
 
 	cl::ParseCommandLineOptions(argc, argv, "global analysis\n");
-	SMDiagnostic Err;
+
+#ifndef FUNCTION_AS_TARGET_TYPE
+	// The summaries cover function target types only, see
+	// SummaryCallGraph::doModulePass()
+	if (MaxResidentModules || FromSummaries || Merge || 
+			SummaryCache != "") {
+		OP << argv[0] << ": -max-resident-modules, -from-summaries, "
+			<< "-merge and -summary-cache need FUNCTION_AS_TARGET_TYPE "
+			<< "in Config.h; struct target types are only supported on "
+			<< "the modules\n";
+		return 1;
+	}
+#endif
+
+	// Keep only the input files of this shard
+	string ListName = "summaries.list";
+	if (Shard != "") {
+		unsigned ShardIdx, NumShards;
+		if (EmitSummary == "" || 
+				sscanf(Shard.c_str(), "%u/%u", &ShardIdx, &NumShards) != 2 ||
+				ShardIdx >= NumShards) {
+			OP << argv[0] << ": -shard=i/N needs -emit-summary "
+				<< "and 0 <= i < N\n";
+			return 1;
+		}
+		size_t NumFiles = InputFilenames.size();
+		size_t Begin = NumFiles * ShardIdx / NumShards;
+		size_t End = NumFiles * (ShardIdx + 1) / NumShards;
+		InputFilenames.erase(InputFilenames.begin() + End, 
+				InputFilenames.end());
+		InputFilenames.erase(InputFilenames.begin(), 
+				InputFilenames.begin() + Begin);
+		ListName = "summaries." + to_string(ShardIdx) + "-of-" + 
+			to_string(NumShards) + ".list";
+	}
 
 	// Loading modules
 	OP << "Total " << InputFilenames.size() << " file(s)\n";
 
-	for (unsigned i = 0; i < InputFilenames.size(); ++i) {
+	SetConfig(MLTA, TyPM, PHASE, CriticalStructs);
 
-		LLVMContext *LLVMCtx = new LLVMContext();
-		std::unique_ptr<Module> M = parseIRFile(InputFilenames[i], Err, *LLVMCtx);
+	vector<SweepPoint> SweepPoints;
+	if (Sweep != "" && !LoadSweepPoints(Sweep, SweepPoints, argv[0]))
+		return 1;
 
-		if (M == NULL) {
-			OP << argv[0] << ": error loading file '"
-				<< InputFilenames[i] << "'\n";
-			continue;
+	if (EmitSummary != "") {
+		vector<ModuleSummary> Summaries;
+		SummarizeModules(&GlobalCtx, Summaries, argv[0]);
+		return EmitSummaries(Summaries, EmitSummary, ListName, 
+				argv[0]) ? 0 : 1;
+	}
+
+	// Build the call graph from module summaries, either computed
+	// here, taken from the summary cache, or read from summary files
+	if (MaxResidentModules || FromSummaries || Merge || 
+			SummaryCache != "") {
+		vector<ModuleSummary> Summaries;
+		if (Merge) {
+			vector<string> Paths;
+			for (string &Dir : InputFilenames) {
+				if (!LoadShardLists(Dir, Paths, argv[0]))
+					return 1;
+			}
+			LoadSummaries(Paths, Summaries, argv[0]);
+		}
+		else if (FromSummaries) {
+			vector<string> Paths(InputFilenames.begin(), 
+					InputFilenames.end());
+			LoadSummaries(Paths, Summaries, argv[0]);
 		}
+		else
+			SummarizeModules(&GlobalCtx, Summaries, argv[0]);
 
-		Module *Module = M.release();
-		StringRef MName = StringRef(strdup(InputFilenames[i].data()));
-		GlobalCtx.Modules.push_back(std::make_pair(Module, MName));
-		GlobalCtx.ModuleMaps[Module] = InputFilenames[i];
+		SummaryCallGraph SCGPass(&GlobalCtx, Summaries);
+		SCGPass.run();
+		SCGPass.printResults();
+
+		return 0;
 	}
 
+	LoadModules(&GlobalCtx, argv[0]);
+
+	if (Sweep != "")
+		return RunSweep(SweepPoints, argv[0]);
+
 	//
 	// Main workflow
 	//
 
 	// Build global callgraph.
-	
-	ENABLE_MLTA = MLTA;
-	ENABLE_TYDM = TyPM;
-	MAX_PHASE_CG = PHASE;
-	if (!ENABLE_TYDM)
-		MAX_PHASE_CG = 1;
 
 	CallGraphPass CGPass(&GlobalCtx);
+
+	// Start reading function bodies once the cross-module tables, which
+	// only need globals and types, have been collected by the pass.
+	// A shared context has read all bodies already.
+	ModulePipeline MPipeline(GlobalCtx.Modules);
+	if (Pipeline && !SharedContext) {
+		MPipeline.start(LoadThreads);
+		GlobalCtx.Pipeline = &MPipeline;
+	}
+
 	CGPass.run(GlobalCtx.Modules);
 	//CGPass.processResults();
 
@@ -6,6 +6,7 @@
 #include <llvm/IR/Instructions.h>
 #include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SparseBitVector.h>
 #include <llvm/ADT/StringExtras.h>
 #include <llvm/Support/Path.h>
 #include <llvm/Support/raw_ostream.h>
@@ -19,21 +20,51 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 #include "Common.h"
+#include "IDSet.h"
+#include "CSRCallGraph.h"
 
 
 // 
 // typedefs
 //
 typedef std::vector< std::pair<llvm::Module*, llvm::StringRef> > ModuleList;
-// Mapping module to its file name.
-typedef std::unordered_map<llvm::Module*, llvm::StringRef> ModuleNameMap;
+// Dense IDs of functions, assigned on first use. The address-taken
+// functions of a module are numbered before it is analyzed, see
+// CallGraphPass::doInitialization(), so target sets stay dense.
+struct FuncIDMap {
+	typedef llvm::Function *value_type;
+	static uint32_t getID(llvm::Function *F);
+	static bool findID(llvm::Function *F, uint32_t &ID) {
+		auto It = IDs.find(F);
+		if (It == IDs.end())
+			return false;
+		ID = It->second;
+		return true;
+	}
+	static llvm::Function *get(uint32_t ID) { return Funcs[ID]; }
+
+	private:
+		static std::vector<llvm::Function *> Funcs;
+		static llvm::DenseMap<llvm::Function *, uint32_t> IDs;
+};
 // The set of all functions.
-typedef llvm::SmallPtrSet<llvm::Function*, 8> FuncSet;
+typedef IDSet<FuncIDMap> FuncSet;
+typedef IDSetPool<FuncIDMap> FuncSetPool;
+typedef IDSetBuilder<FuncIDMap> FuncSetBuilder;
+// A set of modules by their IDs, see GlobalContext::ModuleIDs. It is a
+// compressed bitmap, as runs may have tens of thousands of modules.
+typedef llvm::SparseBitVector<> ModuleSet;
 typedef llvm::SmallPtrSet<llvm::CallInst*, 8> CallInstSet;
 typedef DenseMap<Function*, CallInstSet> CallerMap;
-typedef DenseMap<CallInst *, FuncSet> CalleeMap;
+typedef DenseMap<CallInst *, const FuncSet *> CalleeMap;
+
+class ModulePipeline;
 
 struct GlobalContext {
 
@@ -50,15 +81,51 @@ struct GlobalContext {
 
 	// Global variables
 	DenseMap<size_t, GlobalVariable *>Globals;
-	
-	// Map global function GUID (uint64_t) to its actual function with body.
-	map<uint64_t, Function*> GlobalFuncMap;
+
+	// Symbol resolution, built once all modules are loaded.
+	// Map each global variable to the definition of its GUID in
+	// Globals, i.e., the last one in module order.
+	DenseMap<GlobalVariable *, GlobalVariable *> GlobalDefs;
+	// Function declarations with the same GUID.
+	DenseMap<uint64_t, SmallVector<Function *, 4>> FuncDecls;
+	// Map a function declaration to its actual function with body, in
+	// the last module initialized so far that defines it.
+	DenseMap<Function *, Function *> FuncDefs;
+
+	GlobalVariable *getGlobalDef(GlobalVariable *GV) {
+		auto It = GlobalDefs.find(GV);
+		return It == GlobalDefs.end() ? NULL : It->second;
+	}
+	Function *getFuncDef(Function *F) {
+		auto It = FuncDefs.find(F);
+		return It == FuncDefs.end() ? NULL : It->second;
+	}
 
 	// Functions whose addresses are taken.
 	FuncSet AddressTakenFuncs;
 
-	// Map a callsite to all potential callee functions.
+	// Map an indirect callsite to all potential callee functions. Many
+	// callsites have the same targets, so the sets are shared through
+	// CalleeSets; set the targets with setCallees().
 	CalleeMap Callees;
+	FuncSetPool CalleeSets;
+
+	const FuncSet &getCallees(CallInst *CI) {
+		auto It = Callees.find(CI);
+		return It == Callees.end() ? *CalleeSets.getEmpty() : *It->second;
+	}
+	void setCallees(CallInst *CI, const FuncSet &FS) {
+		Callees[CI] = CalleeSets.intern(FS);
+	}
+
+	// Direct calls with their callees, resolved to the actual
+	// functions, in the order of the analysis. Calls of functions
+	// without body in the analysis scope are left out.
+	std::vector<std::pair<CallInst *, Function *>> DirectCalls;
+
+	// The final call graph, frozen from Callees and DirectCalls after
+	// the analysis
+	CSRCallGraph FinalCG;
 
 	// Map a function to all potential caller instructions.
 #ifdef MAP_CALLER_TO_CALLEE
@@ -73,9 +140,58 @@ struct GlobalContext {
 
 	// Modules.
 	ModuleList Modules;
-	ModuleNameMap ModuleMaps;
+	// Dense ID of each module: its index in Modules
+	DenseMap<Module *, unsigned> ModuleIDs;
 	std::set<std::string> InvolvedModules;
 
+	unsigned getModuleID(Module *M) {
+		auto It = ModuleIDs.find(M);
+		assert(It != ModuleIDs.end());
+		return It->second;
+	}
+
+	// Module ID of a function by its ID in FuncIDMap, looked up once
+	// per function
+	std::vector<unsigned> FuncModuleIDs;
+
+	unsigned getFuncModuleID(uint32_t FID) {
+		if (FID >= FuncModuleIDs.size())
+			FuncModuleIDs.resize(FID + 1, ~0U);
+		unsigned &MID = FuncModuleIDs[FID];
+		if (MID == ~0U)
+			MID = getModuleID(FuncIDMap::get(FID)->getParent());
+		return MID;
+	}
+
+	// Background reader of function bodies, if pipelined
+	ModulePipeline *Pipeline = NULL;
+
+	// Threads for the parallel parts of the initialization; 1 if the
+	// modules share an LLVMContext
+	unsigned NumThreads = 1;
+
+};
+
+// Reads the function bodies of lazily loaded modules on worker
+// threads, in module order, so that reading a module overlaps with the
+// initialization of the modules before it.
+class ModulePipeline {
+public:
+	ModulePipeline(ModuleList &Modules_) : Modules(Modules_) { }
+	~ModulePipeline();
+
+	void start(unsigned NumThreads);
+	// Block until all function bodies of M have been read
+	void waitForModule(llvm::Module *M);
+
+private:
+	ModuleList &Modules;
+	std::vector<std::thread> Workers;
+	std::atomic<unsigned> NextModule{0};
+
+	std::mutex Lock;
+	std::condition_variable Ready;
+	std::unordered_set<llvm::Module *> ReadyModules;
 };
 
 class IterativeModulePass {
@@ -98,6 +214,10 @@ public:
 		{ return false; }
 
 	virtual void run(ModuleList &modules);
+	// The two parts of run(); the initialized state can be reused for
+	// several runs of the iterations, see -sweep
+	void runInitialization(ModuleList &modules);
+	void runIterations(ModuleList &modules);
 };
 
 #endif
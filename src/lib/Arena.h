@@ -0,0 +1,68 @@
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <llvm/Support/Allocator.h>
+#include <functional>
+#include <list>
+#include <map>
+#include <set>
+
+//
+// Arenas for the node-based containers of the analysis, one for each
+// lifetime. Nodes are bump-allocated from the arena of the lifetime
+// and never freed one by one; the arena is released at once when the
+// lifetime ends. All containers on an arena must be cleared or gone
+// by then.
+//
+template <typename LifetimeTy>
+struct Arena {
+	static llvm::BumpPtrAllocator &get() {
+		static llvm::BumpPtrAllocator A;
+		return A;
+	}
+	static void reset() { get().Reset(); }
+};
+
+// The whole analysis. A SummaryBuilder analyzes one module at a time,
+// so its run ends with each module.
+struct RunLifetime { };
+// An iteration of the phases >= 2 of CallGraphPass
+struct PhaseLifetime { };
+// The analysis of a single function
+struct FunctionLifetime { };
+
+typedef Arena<RunLifetime> RunArena;
+typedef Arena<PhaseLifetime> PhaseArena;
+typedef Arena<FunctionLifetime> FunctionArena;
+
+template <typename T, typename ArenaTy>
+class ArenaAllocator {
+
+	public:
+		typedef T value_type;
+		template <typename U> struct rebind {
+			typedef ArenaAllocator<U, ArenaTy> other;
+		};
+
+		ArenaAllocator() { }
+		template <typename U>
+		ArenaAllocator(const ArenaAllocator<U, ArenaTy> &) { }
+
+		T *allocate(size_t N) {
+			return ArenaTy::get().template Allocate<T>(N);
+		}
+		void deallocate(T *, size_t) { }
+
+		bool operator==(const ArenaAllocator &) const { return true; }
+		bool operator!=(const ArenaAllocator &) const { return false; }
+};
+
+template <typename T, typename ArenaTy>
+using ArenaSet = std::set<T, std::less<T>, ArenaAllocator<T, ArenaTy>>;
+template <typename K, typename V, typename ArenaTy>
+using ArenaMap = std::map<K, V, std::less<K>,
+	  ArenaAllocator<std::pair<const K, V>, ArenaTy>>;
+template <typename T, typename ArenaTy>
+using ArenaList = std::list<T, ArenaAllocator<T, ArenaTy>>;
+
+#endif
@@ -0,0 +1,150 @@
+//===-- CSRCallGraph.cc - Final call graph in CSR form ----------===//
+//
+// Freezes the callees resolved by CallGraphPass into flat adjacency
+// arrays. After the analysis, the graph does not change, so walking it
+// should not go through the hash buckets of GlobalContext::Callees.
+//
+//===-----------------------------------------------------------===//
+
+#include "llvm/IR/InstIterator.h"
+
+#include "CSRCallGraph.h"
+#include "Analyzer.h"
+
+using namespace llvm;
+
+void CSRCallGraph::clear() {
+	Funcs.clear();
+	CallSites.clear();
+	FuncIDs.clear();
+	CallSiteIDs.clear();
+	CallSiteBegin.clear();
+	CallSiteFunc.clear();
+	CalleeBegin.clear();
+	CalleeIDs.clear();
+	CallerBegin.clear();
+	CallerIDs.clear();
+}
+
+void CSRCallGraph::build(GlobalContext *Ctx) {
+
+	clear();
+
+	auto getOrAddFunc = [&](Function *F) {
+		auto It = FuncIDs.try_emplace(F, Funcs.size());
+		if (It.second)
+			Funcs.push_back(F);
+		return It.first->second;
+	};
+
+	for (auto &M : Ctx->Modules) {
+		for (Function &F : *M.first)
+			getOrAddFunc(&F);
+	}
+
+	// Call sites with their callees, function by function. Callees
+	// not seen in the modules get an ID after the module functions.
+	// Direct calls were recorded in the same order as the walk below,
+	// so they are consumed from the front of Ctx->DirectCalls.
+	uint32_t NumModuleFuncs = Funcs.size();
+	unsigned NumCallSites = Ctx->Callees.size() + Ctx->DirectCalls.size();
+	auto NextDirect = Ctx->DirectCalls.begin();
+	CallSites.reserve(NumCallSites);
+	CallSiteFunc.reserve(NumCallSites);
+	CalleeBegin.reserve(NumCallSites + 1);
+	CalleeBegin.push_back(0);
+	for (uint32_t F = 0; F < NumModuleFuncs; ++F) {
+		CallSiteBegin.push_back(CallSites.size());
+		for (inst_iterator i = inst_begin(Funcs[F]), e = inst_end(Funcs[F]);
+				i != e; ++i) {
+			CallInst *CI = dyn_cast<CallInst>(&*i);
+			if (!CI)
+				continue;
+
+			size_t Begin = CalleeIDs.size();
+			if (NextDirect != Ctx->DirectCalls.end()
+					&& NextDirect->first == CI) {
+				CalleeIDs.push_back(getOrAddFunc(NextDirect->second));
+				++NextDirect;
+			} else {
+				auto It = Ctx->Callees.find(CI);
+				if (It == Ctx->Callees.end())
+					continue;
+				for (Function *Callee : *It->second)
+					CalleeIDs.push_back(getOrAddFunc(Callee));
+				std::sort(CalleeIDs.begin() + Begin, CalleeIDs.end());
+			}
+
+			CallSiteIDs[CI] = CallSites.size();
+			CallSites.push_back(CI);
+			CallSiteFunc.push_back(F);
+			CalleeBegin.push_back(CalleeIDs.size());
+		}
+	}
+	CallSiteBegin.resize(Funcs.size() + 1, CallSites.size());
+	assert(CallSites.size() == NumCallSites);
+
+	// Reverse edges by counting sort on the callees; the call sites
+	// of each callee stay in the order of their IDs
+	CallerBegin.assign(Funcs.size() + 1, 0);
+	for (uint32_t G : CalleeIDs)
+		++CallerBegin[G + 1];
+	for (uint32_t F = 0; F < Funcs.size(); ++F)
+		CallerBegin[F + 1] += CallerBegin[F];
+	CallerIDs.resize(CalleeIDs.size());
+	std::vector<uint32_t> Next(CallerBegin.begin(), CallerBegin.end() - 1);
+	for (uint32_t C = 0; C < CallSites.size(); ++C) {
+		for (uint32_t G : getCallees(C))
+			CallerIDs[Next[G]++] = C;
+	}
+}
+
+void CSRCallGraph::getReachableFuncs(ArrayRef<uint32_t> Roots,
+		BitVector &Visited, std::vector<uint32_t> &Reached) const {
+
+	Visited.clear();
+	Visited.resize(Funcs.size());
+	Reached.clear();
+	for (uint32_t R : Roots) {
+		if (!Visited.test(R)) {
+			Visited.set(R);
+			Reached.push_back(R);
+		}
+	}
+
+	// Reached is the queue of the search as well
+	for (size_t i = 0; i < Reached.size(); ++i) {
+		for (uint32_t C : getCallSitesIn(Reached[i])) {
+			for (uint32_t G : getCallees(C)) {
+				if (!Visited.test(G)) {
+					Visited.set(G);
+					Reached.push_back(G);
+				}
+			}
+		}
+	}
+}
+
+bool CSRCallGraph::isReachable(uint32_t From, uint32_t To,
+		BitVector &Visited, std::vector<uint32_t> &Reached) const {
+
+	Visited.clear();
+	Visited.resize(Funcs.size());
+	Reached.clear();
+	Visited.set(From);
+	Reached.push_back(From);
+
+	for (size_t i = 0; i < Reached.size(); ++i) {
+		if (Reached[i] == To)
+			return true;
+		for (uint32_t C : getCallSitesIn(Reached[i])) {
+			for (uint32_t G : getCallees(C)) {
+				if (!Visited.test(G)) {
+					Visited.set(G);
+					Reached.push_back(G);
+				}
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,96 @@
+#ifndef _CSR_CALL_GRAPH_H
+#define _CSR_CALL_GRAPH_H
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Sequence.h>
+#include <vector>
+#include <stdint.h>
+
+namespace llvm {
+	class CallInst;
+	class Function;
+}
+
+struct GlobalContext;
+
+//
+// The final call graph, frozen in compressed sparse row form once all
+// callees are resolved, see CallGraphPass::doFinalization(). Functions
+// are numbered densely in module order, and call sites in the order of
+// their functions and instructions, so the call sites of a function
+// are a contiguous range of IDs. Each call site has its callees and
+// each function the call sites that call it, as slices of flat arrays.
+//
+class CSRCallGraph {
+
+	public:
+		// Build the graph from Ctx->Callees and Ctx->DirectCalls
+		void build(GlobalContext *Ctx);
+		void clear();
+
+		unsigned getNumFuncs() const { return Funcs.size(); }
+		unsigned getNumCallSites() const { return CallSites.size(); }
+		unsigned getNumEdges() const { return CalleeIDs.size(); }
+
+		llvm::Function *getFunc(uint32_t F) const { return Funcs[F]; }
+		llvm::CallInst *getCallSite(uint32_t C) const { return CallSites[C]; }
+		// -1 if F is not in the graph
+		int getFuncID(llvm::Function *F) const {
+			auto It = FuncIDs.find(F);
+			return It == FuncIDs.end() ? -1 : (int)It->second;
+		}
+		// -1 if CI has no callees recorded
+		int getCallSiteID(llvm::CallInst *CI) const {
+			auto It = CallSiteIDs.find(CI);
+			return It == CallSiteIDs.end() ? -1 : (int)It->second;
+		}
+
+		// The function that contains call site C
+		uint32_t getCaller(uint32_t C) const { return CallSiteFunc[C]; }
+		// IDs of the call sites in function F
+		auto getCallSitesIn(uint32_t F) const {
+			return llvm::seq(CallSiteBegin[F], CallSiteBegin[F + 1]);
+		}
+		// IDs of the callees of call site C, sorted
+		llvm::ArrayRef<uint32_t> getCallees(uint32_t C) const {
+			return slice(CalleeIDs, CalleeBegin, C);
+		}
+		// IDs of the call sites that may call F, sorted
+		llvm::ArrayRef<uint32_t> getCallers(uint32_t F) const {
+			return slice(CallerIDs, CallerBegin, F);
+		}
+
+		// Functions reachable from Roots, including the roots, in
+		// breadth-first order. Visited and Reached are scratch storage
+		// of the caller, so repeated queries do not allocate.
+		void getReachableFuncs(llvm::ArrayRef<uint32_t> Roots,
+				llvm::BitVector &Visited, std::vector<uint32_t> &Reached) const;
+		bool isReachable(uint32_t From, uint32_t To,
+				llvm::BitVector &Visited, std::vector<uint32_t> &Reached) const;
+
+	private:
+		std::vector<llvm::Function *> Funcs;
+		std::vector<llvm::CallInst *> CallSites;
+		llvm::DenseMap<llvm::Function *, uint32_t> FuncIDs;
+		llvm::DenseMap<llvm::CallInst *, uint32_t> CallSiteIDs;
+
+		// Call sites of function F: [CallSiteBegin[F], CallSiteBegin[F+1])
+		std::vector<uint32_t> CallSiteBegin;
+		std::vector<uint32_t> CallSiteFunc;
+		// Forward edges, call site -> callee functions
+		std::vector<uint32_t> CalleeBegin;
+		std::vector<uint32_t> CalleeIDs;
+		// Reverse edges, callee function -> call sites
+		std::vector<uint32_t> CallerBegin;
+		std::vector<uint32_t> CallerIDs;
+
+		static llvm::ArrayRef<uint32_t> slice(const std::vector<uint32_t> &A,
+				const std::vector<uint32_t> &Begin, uint32_t I) {
+			return llvm::ArrayRef<uint32_t>(A.data() + Begin[I],
+					A.data() + Begin[I + 1]);
+		}
+};
+
+#endif
@@ -62,33 +62,38 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 		// Map callsite to possible callees.
 		if (CallInst *CI = dyn_cast<CallInst>(&*i)) {
 
-			CallSet.insert(CI);
-
-			FuncSet *FS = &Ctx->Callees[CI];
 			Value *CV = CI->getCalledOperand();
 			Function *CF = dyn_cast<Function>(CV);
 
 			// Indirect call
 			if (CI->isIndirectCall()) {
 
+				// The shared target set, see GlobalContext::CalleeSets
+				const FuncSet *FS = Ctx->CalleeSets.getEmpty();
+
 				// Multi-layer type matching
 				if (ENABLE_MLTA > 1) {
-					findCalleesWithMLTA(CI, *FS);
+					FuncSet Targets;
+					findCalleesWithMLTA(CI, Targets);
+					FS = Ctx->CalleeSets.intern(Targets);
 				}
 				// Fuzzy type matching
 				else if (ENABLE_MLTA == 0) {
 					size_t CIH = callHash(CI);
-					if (MatchedICallTypeMap.find(CIH) 
-							!= MatchedICallTypeMap.end())
-						*FS = MatchedICallTypeMap[CIH];
+					auto It = MatchedICallTypeMap.find(CIH);
+					if (It != MatchedICallTypeMap.end())
+						FS = It->second;
 					else {
-						findCalleesWithType(CI, *FS);
-						MatchedICallTypeMap[CIH] = *FS;
+						FuncSet Targets;
+						findCalleesWithType(CI, Targets);
+						FS = Ctx->CalleeSets.intern(Targets);
+						MatchedICallTypeMap[CIH] = FS;
 					}
 				}
 				// One-layer type matching
 				else {
-					*FS = Ctx->sigFuncsMap[callHash(CI)];
+					FS = Ctx->CalleeSets.intern(
+							Ctx->sigFuncsMap[callHash(CI)]);
 				}
 
 #ifdef MAP_CALLER_TO_CALLEE
@@ -106,6 +111,7 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 					Ctx->NumIndirectCallTargets += FS->size();
 					Ctx->NumValidIndirectCalls++;
 				}
+				Ctx->Callees[CI] = FS;
 			}
 			// Direct call
 			else {
@@ -116,15 +122,17 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 						//StringRef FName = CF->getName();
 						//if (FName.startswith("SyS_"))
 						//	FName = StringRef("sys_" + FName.str().substr(4));
-						if (Function *GF = Ctx->GlobalFuncMap[CF->getGUID()])
+						if (Function *GF = Ctx->getFuncDef(CF))
 							CF = GF;
 					}
 
-					FS->insert(CF);
-
 #ifdef MAP_CALLER_TO_CALLEE
 					Ctx->Callers[CF].insert(CI);
 #endif
+					// Only calls to functions with body are kept, see
+					// GlobalContext::DirectCalls
+					if (!CF->isDeclaration())
+						Ctx->DirectCalls.push_back(std::make_pair(CI, CF));
 				}
 				// InlineAsm
 				else {
@@ -168,6 +176,7 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 	}
 
 	void CallGraphPass::PhaseTyPM(Function *F) {
+
 		for (inst_iterator i = inst_begin(F), e = inst_end(F); 
 				i != e; ++i) {
 
@@ -187,10 +196,10 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 			// Indirect call
 			if (CI->isIndirectCall()) {
 
-				for (auto CF : Ctx->Callees[CI]) {
+				for (auto CF : Ctx->getCallees(CI)) {
 					// Need to use the actual function with body here
 					if (CF->isDeclaration())
-						CF = Ctx->GlobalFuncMap[CF->getGUID()];
+						CF = Ctx->getFuncDef(CF);
 					if (!CF) {
 						continue;
 					}
@@ -217,7 +226,7 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 				}
 				// Need to use the actual function with body here
 				if (CF->isDeclaration()) {
-					CF = Ctx->GlobalFuncMap[CF->getGUID()];
+					CF = Ctx->getFuncDef(CF);
 					if (!CF) {
 						// Have to skip it as the function body is not in
 						// the analysis scope
@@ -232,39 +241,79 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 		}
 	}
 
-	bool CallGraphPass::doInitialization(Module *M) {
-
-		OP<<"#"<<MIdx<<" Initializing: "<<M->getName()<<"\n";
-
-		++ MIdx;
+	// Collect global variables with initializers and function
+	// declarations of all modules, and resolve each global variable to
+	// its definition. This only needs the globals, so it is done before
+	// any function body of a lazily loaded module is read.
+	void CallGraphPass::collectSymbols() {
 
-		DLMap[M] = &(M->getDataLayout());
-		Int8PtrTy[M] = Type::getInt8PtrTy(M->getContext());
-		assert(Int8PtrTy[M]);
-		IntPtrTy[M] = DLMap[M]->getIntPtrType(M->getContext());
+		for (auto MN : Ctx->Modules) {
+			Module *M = MN.first;
+			for (Module::global_iterator gi = M->global_begin(); 
+					gi != M->global_end(); ++gi) {
 
-		set<User *>CastSet;
-
-		//
-		// Do something at the begining 
-		//
-		if (1 == MIdx) {
-			for (auto MN : Ctx->Modules) {
-				Module *M = MN.first;
-				for (Module::global_iterator gi = M->global_begin(); 
-						gi != M->global_end(); ++gi) {
-
-					GlobalVariable* GV = &*gi;
-					if (GV->hasInitializer()) {
-						Ctx->Globals[GV->getGUID()] = GV;
-					}
+				GlobalVariable* GV = &*gi;
+				if (GV->hasInitializer()) {
+					Ctx->Globals[GV->getGUID()] = GV;
 				}
+			}
 
+			for (Function &F : *M) {
+				if (F.isDeclaration() && !F.isIntrinsic())
+					Ctx->FuncDecls[F.getGUID()].push_back(&F);
 			}
+		}
 
+		for (auto MN : Ctx->Modules) {
+			Module *M = MN.first;
+			for (GlobalVariable &GV : M->globals()) {
+				auto It = Ctx->Globals.find(GV.getGUID());
+				if (It != Ctx->Globals.end())
+					Ctx->GlobalDefs[&GV] = It->second;
+			}
 		}
+	}
+
+	bool CallGraphPass::doInitialization(Module *M) {
+
+		// With -pipeline, function bodies are read by background workers
+		if (Ctx->Pipeline)
+			Ctx->Pipeline->waitForModule(M);
+
+		OP<<"#"<<MIdx<<" Initializing: "<<M->getName()<<"\n";
 
+		++ MIdx;
+
+		ModuleInfo &MI = getModuleInfo(M);
+		MI.DL = &(M->getDataLayout());
+		MI.Int8PtrTy = Type::getInt8PtrTy(M->getContext());
+		assert(MI.Int8PtrTy);
+		MI.IntPtrTy = MI.DL->getIntPtrType(M->getContext());
+
+		// The following analyses walk use lists, e.g., for
+		// address-taken functions and stores to globals, which are
+		// complete only after all bodies of the module have been read
+		materializeModule(M);
+
+		// Collect address-taken functions. They are numbered before
+		// any other function of the module gets an ID, see FuncIDMap.
+		// NOTE: declaration functions can also have address taken 
+		for (Function &F : *M) {
+			if (F.isIntrinsic() || !F.hasAddressTaken())
+				continue;
+			Ctx->AddressTakenFuncs.insert(&F);
+			size_t FuncHash = funcHash(&F, false);
+			Ctx->sigFuncsMap[FuncHash].insert(&F);
+			StringRef FName = F.getName();
+			// The following functions are not in the analysis scope
+			if (FName.startswith("__x64") ||
+					FName.startswith("__ia32") ||
+					FName.startswith("__do_sys")) {
+				OutScopeFuncNames.insert(F.getName().str());
+			}
+		}
 
+		set<User *>CastSet;
 
 		//
 		// Iterate and process globals
@@ -282,8 +331,7 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 				//Ctx->Globals[GV->getGUID()] = GV;
 
 				// Parse the initializer
-				set<Type *>TySet;
-				findTargetTypesInInitializer(GV, M, TySet);
+				findTargetTypesInInitializer(GV, M);
 
 				typeConfineInInitializer(GV);
 
@@ -300,30 +348,19 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 				continue;
 			}
 
-			// Collect address-taken functions.
-			// NOTE: declaration functions can also have address taken 
-			if (F.hasAddressTaken()) {
-				Ctx->AddressTakenFuncs.insert(&F);
-				size_t FuncHash = funcHash(&F, false);
-				Ctx->sigFuncsMap[FuncHash].insert(&F);
-				StringRef FName = F.getName();
-				// The following functions are not in the analysis scope
-				if (FName.startswith("__x64") ||
-						FName.startswith("__ia32") ||
-						FName.startswith("__do_sys")) {
-					OutScopeFuncNames.insert(F.getName().str());
-				}
-			}
-
 			// The following only considers actual functions with body
 			if (F.isDeclaration()) {
 				continue;
 			}
 			++Ctx->NumFunctions;
 
-			// Collect global function definitions.
+			// Resolve the declarations of global function definitions.
 			if (F.hasExternalLinkage()) {
-				Ctx->GlobalFuncMap[F.getGUID()] = &F;
+				auto It = Ctx->FuncDecls.find(F.getGUID());
+				if (It != Ctx->FuncDecls.end()) {
+					for (Function *Decl : It->second)
+						Ctx->FuncDefs[Decl] = &F;
+				}
 			}
 
 
@@ -334,7 +371,7 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 				typePropInFunction(&F);
 			}
 
-			collectAliasStructPtr(&F);
+			collectAliasStructPtr(&F, getModuleInfo(M));
 			typeConfineInFunction(&F);
 
 			// Collect all casts in the function
@@ -349,6 +386,8 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 
 			// Collection allocations of critical data structures
 			findTargetAllocInFunction(&F);
+
+			FunctionArena::reset();
 		}
 
 
@@ -358,34 +397,15 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 		//
 		if (Ctx->Modules.size() == MIdx) {
 
+			typeFacts.flushTargets();
+			NewStoredFuncs.flush(StoredFuncs);
 			if (ENABLE_MLTA > 1) {
 				// Map the declaration functions to actual ones
 				// NOTE: to delete an item, must iterate by reference
-				for (auto &SF : Ctx->sigFuncsMap) {
-					for (auto F : SF.second) {
-						if (!F)
-							continue;
-						if (F->isDeclaration()) {
-							SF.second.erase(F);
-							if (Function *AF = Ctx->GlobalFuncMap[F->getGUID()]) {
-								SF.second.insert(AF);
-							}
-						}
-					}
-				}
-
-				for (auto &TF : typeIdxFuncsMap) {
-					for (auto &IF : TF.second) {
-						for (auto F : IF.second) {
-							if (F->isDeclaration()) {
-								IF.second.erase(F);
-								if (Function *AF = Ctx->GlobalFuncMap[F->getGUID()]) {
-									IF.second.insert(AF);
-								}
-							}
-						}
-					}
-				}
+				for (auto &SF : Ctx->sigFuncsMap)
+					mapDeclToActualFuncs(SF.second);
+				for (auto &FS : typeFacts.FieldTargets)
+					mapDeclToActualFuncs(FS);
 			}
 
 			MIdx = 0;
@@ -401,14 +421,16 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 			// Finally map declaration functions to actual functions
 			OP<<"Mapping declaration functions to actual ones...\n";
 			Ctx->NumIndirectCallTargets = 0;
-			for (auto CI : CallSet) {
-				mapDeclToActualFuncs(Ctx->Callees[CI]);
-
-				if (CI->isIndirectCall()) {
-					Ctx->NumIndirectCallTargets += Ctx->Callees[CI].size();
-					printTargets(Ctx->Callees[CI], CI);
-				}
+			// Direct calls are resolved already, see PhaseMLTA()
+			for (auto CI : ICallSet) {
+				FuncSet FS = Ctx->getCallees(CI);
+				mapDeclToActualFuncs(FS);
+				Ctx->setCallees(CI, FS);
+
+				Ctx->NumIndirectCallTargets += FS.size();
+				printTargets(FS, CI);
 			}
+			Ctx->FinalCG.build(Ctx);
 
 
 #if 0
@@ -447,21 +469,23 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 #else
 
 				if (!GV->hasInitializer()) {
-					GV = Ctx->Globals[GV->getGUID()];
+					GV = Ctx->getGlobalDef(GV);
 					if (!GV) {
 						continue;
 					}
 				}
 
-				set<Type *>TySet;
-				findTargetTypesInValue(GV->getInitializer(), TySet, M);
+				const TypeList &TySet =
+					findTargetTypesInValue(GV->getInitializer(), M);
 				for (auto Ty : TySet) {
 
 					// TODO: can be optimized for better precision: either from
 					// or to
 					size_t TyH;
-					TypesFromModuleGVMap[make_pair(GV->getGUID(), TyH)].insert(M);
-					TypesToModuleGVMap[make_pair(GV->getGUID(), TyH)].insert(M);
+					TypesFromModuleGVMap[make_pair(GV->getGUID(), TyH)].set(
+							Ctx->getModuleID(M));
+					TypesToModuleGVMap[make_pair(GV->getGUID(), TyH)].set(
+							Ctx->getModuleID(M));
 				}
 
 #endif
@@ -470,12 +494,11 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 		}
 		if (MIdx == Ctx->Modules.size()) {
 			// Use globals to connect modules
-			for (auto GMM : TypesToModuleGVMap) {
+			for (auto &GMM : TypesToModuleGVMap) {
 				for (auto DstM : GMM.second) {
 					size_t TyH = GMM.first.second;
-					moPropMap[make_pair(DstM, TyH)].insert(
-							TypesFromModuleGVMap[GMM.first].begin(),
-							TypesFromModuleGVMap[GMM.first].end());
+					moPropMap[make_pair(DstM, TyH)] |=
+						TypesFromModuleGVMap[GMM.first];
 				}
 			}
 #if 0
@@ -506,6 +529,7 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 				// TODO: only iterate over indirect calls
 				PhaseTyPM(F);
 			}
+			FunctionArena::reset();
 		}
 
 		// Analysis phase control
@@ -522,14 +546,14 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 
 			if (AnalysisPhase >= 2) {
 
-				ResolvedDepModulesMap.clear();
 				bool Iter = true;
 				// Merge the propagation maps
 				moPropMapAll.insert(moPropMap.begin(), moPropMap.end());
 				// Add map one by one to avoid overwritting
-				for (auto m : moPropMapV) {
-					moPropMapAll[m.first].insert(m.second.begin(), m.second.end());
+				for (auto &m : moPropMapV) {
+					moPropMapAll[m.first] |= m.second;
 				}
+				buildDependentModules();
 
 				// TODO: multi-threading for better performance
 
@@ -551,9 +575,11 @@ void CallGraphPass::PhaseMLTA(Function *F) {
 
 				// Reset the map when phase >= 2
 				moPropMapV.clear();
+				DepModules.clear();
 				moPropMapAll.clear();
 				ParsedModuleTypeICallMap.clear();
 				ParsedModuleTypeDCallMap.clear();
+				PhaseArena::reset();
 			}
 
 			++AnalysisPhase;
@@ -28,6 +28,8 @@ class CallGraphPass :
 		void PhaseMLTA(Function *F);
 		void PhaseTyPM(Function *F);
 
+		void collectSymbols();
+
 
 	public:
 		static int AnalysisPhase;
@@ -36,7 +38,8 @@ class CallGraphPass :
 			: IterativeModulePass(Ctx_, "CallGraph"), 
 			TyPM(Ctx_) {
 
-				LoadElementsStructNameMap(Ctx->Modules);
+				LoadElementsStructNameMap(Ctx->Modules, Ctx->NumThreads);
+				collectSymbols();
 				MIdx = 0;
 
 				time_t my_time = time(NULL);
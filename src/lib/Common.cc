@@ -4,12 +4,15 @@
 #include <llvm/IR/Operator.h>
 #include <fstream>
 #include <regex>
+#include <thread>
+#include <atomic>
+#include <llvm/Support/xxhash.h>
 #include "Common.h"
 #include "Config.h"
 
 
-// Map from struct elements to its name
-static map<string, set<StringRef>>elementsStructNameMap;
+// Map from the shape of structs to their names, sorted
+static DenseMap<uint64_t, SmallVector<StringRef, 1>>elementsStructNameMap;
 
 bool trimPathSlash(string &path, int slash) {
 	while (slash > 0) {
@@ -29,6 +32,12 @@ string getFileName(DILocation *Loc, DISubprogram *SP) {
 	else
 		return "";
 
+	return getSourcePath(FN);
+}
+
+// Map a file name in debug info to the path of the source file
+string getSourcePath(string FN) {
+
 	int slashToTrim = 2;
 	char *user = getlogin();
 	if (strstr(user, "kjlu")) {
@@ -364,36 +373,317 @@ Argument *getParamByArgNo(Function *F, int8_t ArgNo) {
 	return ai;
 }
 
+// Read all remaining function bodies of a lazily loaded module. This
+// also releases the bitcode reader and its buffer
+bool materializeModule(Module *M) {
+
+	if (!M->getMaterializer())
+		return true;
+
+	if (Error E = M->materializeAll()) {
+		OP << "== Warning: failed to materialize " << M->getName()
+			<< ": " << toString(std::move(E)) << "\n";
+		return false;
+	}
+	return true;
+}
+
 void LoadElementsStructNameMap(
-		vector<pair<Module*, StringRef>> &Modules) {
+		vector<pair<Module*, StringRef>> &Modules, unsigned NumThreads) {
+
+	// Shapes are computed in parallel, each module in its own
+	// LLVMContext, and merged in module order
+	vector<vector<pair<uint64_t, StringRef>>> ModuleShapes(Modules.size());
+	atomic<unsigned> NextModule(0);
+	auto Worker = [&]() {
+		unsigned i;
+		while ((i = NextModule++) < Modules.size()) {
+			for (auto STy : Modules[i].first->getIdentifiedStructTypes()) {
+				// Unnamed structs have no name to map to
+				if (!STy->hasName() || STy->isOpaque())
+					continue;
+
+				ModuleShapes[i].push_back(make_pair(structShapeHash(STy),
+							structName(STy)));
+			}
+		}
+	};
+
+	NumThreads = std::max(1u, std::min(NumThreads, 
+				(unsigned)Modules.size()));
+	vector<thread> Workers;
+	for (unsigned t = 1; t < NumThreads; ++t)
+		Workers.push_back(thread(Worker));
+	Worker();
+	for (auto &T : Workers)
+		T.join();
+
+	for (auto &Shapes : ModuleShapes) {
+		for (auto &SN : Shapes)
+			elementsStructNameMap[SN.first].push_back(SN.second);
+	}
+	for (auto &SN : elementsStructNameMap) {
+		auto &Names = SN.second;
+		llvm::sort(Names);
+		Names.erase(unique(Names.begin(), Names.end()), Names.end());
+	}
+	// Hashes of unnamed structs depend on the map
+	clearTypeHashCache();
+}
 
-	for (auto M : Modules) {
-		for (auto STy : M.first->getIdentifiedStructTypes()) {
-			assert(STy->hasName());
-			if (STy->isOpaque())
-				continue;
+// Original names of renamed structs, see -shared-context
+static StringMap<string> RenamedStructNames;
+
+// Structs taken out of the symbol table of the shared context, with
+// their names in the bitcode
+static vector<pair<StructType *, string>> DetachedStructNames;
+
+// Take the structs of M, which has just been parsed into the shared
+// context, out of the symbol table of the context. The context has no
+// other named structs then, so M got the names of its bitcode, and the
+// next module will get the names of its own.
+void detachStructNames(Module *M) {
+
+	for (StructType *STy : M->getIdentifiedStructTypes()) {
+		if (!STy->hasName())
+			continue;
+		DetachedStructNames.push_back(make_pair(STy, STy->getName().str()));
+		STy->setName("");
+	}
+}
+
+// Put the names back once all modules are parsed. The context renames
+// a struct whose name is already taken, which is recorded here.
+void restoreStructNames() {
+
+	for (auto &SN : DetachedStructNames) {
+		SN.first->setName(SN.second);
+		StringRef Name = SN.first->getName();
+		if (Name != SN.second)
+			RenamedStructNames[Name] = SN.second;
+	}
+	DetachedStructNames.clear();
+	DetachedStructNames.shrink_to_fit();
+}
+
+// The original name of a struct
+StringRef structName(StructType *STy) {
+
+	StringRef Name = STy->getName();
+	if (RenamedStructNames.empty())
+		return Name;
+	auto It = RenamedStructNames.find(Name);
+	if (It == RenamedStructNames.end())
+		return Name;
+	return It->second;
+}
+
+// Stable tags of the kinds of types; Type::TypeID differs between
+// LLVM versions
+enum TypeHashTag {
+	THT_Other = 1,
+	THT_Void,
+	THT_Half,
+	THT_BFloat,
+	THT_Float,
+	THT_Double,
+	THT_X86_FP80,
+	THT_FP128,
+	THT_PPC_FP128,
+	THT_Label,
+	THT_Metadata,
+	THT_X86_MMX,
+	THT_X86_AMX,
+	THT_Token,
+	THT_Integer,
+	THT_Function,
+	THT_Pointer,
+	THT_Struct,
+	THT_Array,
+	THT_FixedVector,
+	THT_ScalableVector,
+	THT_TopLevelArray,
+};
+
+static uint64_t typeHashTag(Type *Ty) {
+	switch (Ty->getTypeID()) {
+		case Type::VoidTyID: return THT_Void;
+		case Type::HalfTyID: return THT_Half;
+		case Type::BFloatTyID: return THT_BFloat;
+		case Type::FloatTyID: return THT_Float;
+		case Type::DoubleTyID: return THT_Double;
+		case Type::X86_FP80TyID: return THT_X86_FP80;
+		case Type::FP128TyID: return THT_FP128;
+		case Type::PPC_FP128TyID: return THT_PPC_FP128;
+		case Type::LabelTyID: return THT_Label;
+		case Type::MetadataTyID: return THT_Metadata;
+		case Type::X86_MMXTyID: return THT_X86_MMX;
+		case Type::X86_AMXTyID: return THT_X86_AMX;
+		case Type::TokenTyID: return THT_Token;
+		case Type::IntegerTyID: return THT_Integer;
+		case Type::FunctionTyID: return THT_Function;
+		case Type::PointerTyID: return THT_Pointer;
+		case Type::StructTyID: return THT_Struct;
+		case Type::ArrayTyID: return THT_Array;
+		case Type::FixedVectorTyID: return THT_FixedVector;
+		case Type::ScalableVectorTyID: return THT_ScalableVector;
+		default: return THT_Other;
+	}
+}
+
+static inline uint64_t hashMix(uint64_t H, uint64_t V) {
+	return H ^ (V + 0x9e3779b97f4a7c15ULL + (H << 6) + (H >> 2));
+}
+
+size_t strHash(StringRef Str) {
+	return xxHash64(Str);
+}
+
+// The this pointer of a C++ method: a pointer to a class
+static bool isClassThisPtr(Type *Ty) {
+
+	PointerType *PTy = dyn_cast<PointerType>(Ty);
+	if (!PTy || PTy->isOpaque() || PTy->getAddressSpace() != 0)
+		return false;
+	StructType *STy = dyn_cast<StructType>(PTy->getPointerElementType());
+	if (!STy || !STy->hasName())
+		return false;
+	StringRef Name = structName(STy);
+	if (!Name.consume_front("class.") || Name.empty())
+		return false;
+	for (char C : Name) {
+		if (!isalnum(C) && C != '_')
+			return false;
+	}
+	return true;
+}
+
+// Structural hash of a type within another type. As in the printed
+// type, identified structs are referred to by their names; an unnamed
+// identified struct, which may refer to itself, only by its size.
+// If StripThis is set, the this pointer of the first function type
+// that has one, in printing order, is skipped, and StripThis is
+// cleared.
+static uint64_t nestedTypeHash(Type *Ty, bool *StripThis = nullptr) {
+
+	uint64_t H = hashMix(0, typeHashTag(Ty));
+	switch (Ty->getTypeID()) {
+		case Type::IntegerTyID:
+			return hashMix(H, Ty->getIntegerBitWidth());
+
+		case Type::PointerTyID: {
+			PointerType *PTy = cast<PointerType>(Ty);
+			H = hashMix(H, PTy->getAddressSpace());
+			if (PTy->isOpaque())
+				return H;
+			return hashMix(H, nestedTypeHash(PTy->getPointerElementType(),
+						StripThis));
+		}
+
+		case Type::StructTyID: {
+			StructType *STy = cast<StructType>(Ty);
+			if (STy->hasName())
+				return hashMix(H, strHash(structName(STy)));
+			H = hashMix(H, STy->isLiteral());
+			H = hashMix(H, STy->isPacked());
+			H = hashMix(H, STy->getNumElements());
+			if (STy->isLiteral()) {
+				for (Type *ETy : STy->elements())
+					H = hashMix(H, nestedTypeHash(ETy, StripThis));
+			}
+			return H;
+		}
 
-			string strSTy = structTyStr(STy);
-			elementsStructNameMap[strSTy].insert(STy->getName());  
+		case Type::ArrayTyID:
+			H = hashMix(H, Ty->getArrayNumElements());
+			return hashMix(H, nestedTypeHash(Ty->getArrayElementType(),
+						StripThis));
+
+		case Type::FixedVectorTyID:
+		case Type::ScalableVectorTyID: {
+			VectorType *VTy = cast<VectorType>(Ty);
+			H = hashMix(H, VTy->getElementCount().getKnownMinValue());
+			return hashMix(H, nestedTypeHash(VTy->getElementType(),
+						StripThis));
 		}
+
+		case Type::FunctionTyID: {
+			FunctionType *FTy = cast<FunctionType>(Ty);
+			uint64_t RetH = nestedTypeHash(FTy->getReturnType(), StripThis);
+			auto PI = FTy->param_begin();
+			if (StripThis && *StripThis && PI != FTy->param_end() &&
+					isClassThisPtr(*PI)) {
+				*StripThis = false;
+				++PI;
+			}
+			H = hashMix(H, FTy->isVarArg());
+			H = hashMix(H, FTy->param_end() - PI);
+			H = hashMix(H, RetH);
+			for (; PI != FTy->param_end(); ++PI)
+				H = hashMix(H, nestedTypeHash(*PI, StripThis));
+			return H;
+		}
+
+		default:
+			return H;
 	}
 }
 
-void cleanString(string &str) {
-	// process string
-	// remove c++ class type added by compiler
-	size_t pos = str.find("(%class.");
-	if (pos != string::npos) {
-		//regex pattern1("\\(\\%class\\.[_A-Za-z0-9]+\\*,?");
-		regex pattern("^[_A-Za-z0-9]+\\*,?");
-		smatch match;
-		string str_sub = str.substr(pos + 8);
-		if (regex_search(str_sub, match, pattern)) {
-			str.replace(pos + 1, 7 + match[0].length(), "");
+// Hash of a function signature; the this pointer of C++ methods is
+// ignored, so methods can match plain function pointers
+static size_t computeSigHash(FunctionType *FTy) {
+	bool StripThis = true;
+	return nestedTypeHash(FTy, &StripThis);
+}
+
+// Shape of a type in a struct: nested aggregates are expanded and
+// pointers are reduced to the address space and the kind of their
+// pointee. The layout follows from the shape, as all modules share
+// the data layout of the target.
+static uint64_t shapeHash(Type *Ty) {
+
+	uint64_t H = hashMix(0, typeHashTag(Ty));
+	switch (Ty->getTypeID()) {
+		case Type::IntegerTyID:
+			return hashMix(H, Ty->getIntegerBitWidth());
+
+		case Type::PointerTyID: {
+			PointerType *PTy = cast<PointerType>(Ty);
+			H = hashMix(H, PTy->getAddressSpace());
+			if (PTy->isOpaque())
+				return H;
+			return hashMix(H, typeHashTag(PTy->getPointerElementType()));
+		}
+
+		case Type::StructTyID: {
+			StructType *STy = cast<StructType>(Ty);
+			if (STy->isOpaque())
+				return H;
+			H = hashMix(H, STy->isPacked());
+			H = hashMix(H, STy->getNumElements());
+			for (Type *ETy : STy->elements())
+				H = hashMix(H, shapeHash(ETy));
+			return H;
+		}
+
+		case Type::ArrayTyID:
+			H = hashMix(H, Ty->getArrayNumElements());
+			return hashMix(H, shapeHash(Ty->getArrayElementType()));
+
+		case Type::FixedVectorTyID:
+		case Type::ScalableVectorTyID: {
+			VectorType *VTy = cast<VectorType>(Ty);
+			H = hashMix(H, VTy->getElementCount().getKnownMinValue());
+			return hashMix(H, shapeHash(VTy->getElementType()));
 		}
+
+		default:
+			return H;
 	}
-	string::iterator end_pos = remove(str.begin(), str.end(), ' ');
-	str.erase(end_pos, str.end());
+}
+
+uint64_t structShapeHash(StructType *STy) {
+	return shapeHash(STy);
 }
 
 //#define HASH_SOURCE_INFO
@@ -415,34 +705,20 @@ string funcTypeString(FunctionType *FTy) {
 
 size_t funcHash(Function *F, bool withName) {
 
-	hash<string> str_hash;
-	string output;
-
 #ifdef HASH_SOURCE_INFO
 	DISubprogram *SP = F->getSubprogram();
 
 	if (SP) {
-		output = SP->getFilename();
+		string output = SP->getFilename();
 		output = output + to_string(uint_hash(SP->getLine()));
-	}
-	else {
-#endif
-		string sig;
-		raw_string_ostream rso(sig);
-		FunctionType *FTy = F->getFunctionType();
-		FTy->print(rso);
-		output = rso.str();
-		//output = funcTypeString(FTy);
-
-		if (withName)
-			output += F->getName();
-#ifdef HASH_SOURCE_INFO
+		return strHash(output);
 	}
 #endif
-	// process string
-	cleanString(output);
+	size_t Hash = sigHash(F->getFunctionType());
+	if (withName)
+		Hash = hashMix(Hash, strHash(F->getName()));
 
-	return str_hash(output);
+	return Hash;
 }
 
 size_t callHash(CallInst *CI) {
@@ -454,96 +730,91 @@ size_t callHash(CallInst *CI) {
 	//	if (CF)
 	//		return funcHash(CF);
 	//}
-	hash<string> str_hash;
-	string sig;
-	raw_string_ostream rso(sig);
-	FunctionType *FTy = CB->getFunctionType();
-	FTy->print(rso);
-	string strip_str = rso.str();
-	//string strip_str = funcTypeString(FTy);
-	cleanString(strip_str);
-
-	return str_hash(strip_str);
-}
-
-string structTyStr(StructType *STy) {
-	string ty_str;
-	string sig;
-	for (auto Ty : STy->elements()) {
-		ty_str += to_string(Ty->getTypeID());
-	}
-	return ty_str;
+	return sigHash(CB->getFunctionType());
 }
 
 void structTypeHash(StructType *STy, set<size_t> &HSet) {
-	hash<string> str_hash;
-	string sig;
 	string ty_str;
 
 	// TODO: Use more but reliable information
 	// FIXME: A few cases may not even have a name
 	if (STy->hasName()) {
-		ty_str = STy->getName().str();
-		HSet.insert(str_hash(ty_str));
+		ty_str = structName(STy).str();
+		HSet.insert(strHash(ty_str));
 	}
 	else {
-		string sstr = structTyStr(STy);
-		if (elementsStructNameMap.find(sstr) 
-				!= elementsStructNameMap.end()) {
-			for (auto SStr : elementsStructNameMap[sstr]) {
-				ty_str = SStr.str();
-				HSet.insert(str_hash(ty_str));
-			}
+		auto It = elementsStructNameMap.find(structShapeHash(STy));
+		if (It != elementsStructNameMap.end()) {
+			for (auto SStr : It->second)
+				HSet.insert(strHash(SStr));
 		}
 	}
 }
 
-size_t typeHash(Type *Ty) {
-	hash<string> str_hash;
-	string sig;
+static size_t computeTypeHash(Type *Ty) {
 	string ty_str;
 
 	if (StructType *STy = dyn_cast<StructType>(Ty)) {
 		// TODO: Use more but reliable information
 		// FIXME: A few cases may not even have a name
 		if (STy->hasName()) {
-			ty_str = STy->getName().str();
+			ty_str = structName(STy).str();
 		}
 		else {
-			string sstr = structTyStr(STy);
-			if (elementsStructNameMap.find(sstr) 
-					!= elementsStructNameMap.end()) {
-				ty_str = elementsStructNameMap[sstr].begin()->str();
-			}
+			auto It = elementsStructNameMap.find(structShapeHash(STy));
+			if (It != elementsStructNameMap.end())
+				ty_str = It->second.front().str();
 		}
+		return strHash(ty_str);
 	}
 #ifdef SOUND_MODE
-	else if (ArrayType *ATy = dyn_cast<ArrayType>(Ty)) {
+	else if (isa<ArrayType>(Ty)) {
 
 		// Compiler sometimes fails recoginize size of array (compiler
 		// bug?), so let's just use the element type
 
 		//Ty = ATy->getElementType();
-		raw_string_ostream rso(sig);
-		Ty->print(rso);
-		ty_str = rso.str() + "[array]";
-		string::iterator end_pos = remove(ty_str.begin(), ty_str.end(), ' ');
-		ty_str.erase(end_pos, ty_str.end());
+		return hashMix(THT_TopLevelArray, nestedTypeHash(Ty));
 	}
 #endif
-	else {
-		raw_string_ostream rso(sig);
-		Ty->print(rso);
-		ty_str = rso.str();
-		string::iterator end_pos = remove(ty_str.begin(), ty_str.end(), ' ');
-		ty_str.erase(end_pos, ty_str.end());
-	}
-	return str_hash(ty_str);
+	return nestedTypeHash(Ty);
+}
+
+// typeHash() and sigHash() of each type, as walking a type is
+// expensive. Types are never freed before their LLVMContext, see
+// clearTypeHashCache()
+static DenseMap<Type *, size_t> TypeHashCache;
+static DenseMap<FunctionType *, size_t> SigHashCache;
+
+void clearTypeHashCache() {
+	TypeHashCache.clear();
+	SigHashCache.clear();
+}
+
+size_t typeHash(Type *Ty) {
+
+	auto It = TypeHashCache.find(Ty);
+	if (It != TypeHashCache.end())
+		return It->second;
+
+	size_t Hash = computeTypeHash(Ty);
+	TypeHashCache[Ty] = Hash;
+	return Hash;
+}
+
+size_t sigHash(FunctionType *FTy) {
+
+	auto It = SigHashCache.find(FTy);
+	if (It != SigHashCache.end())
+		return It->second;
+
+	size_t Hash = computeSigHash(FTy);
+	SigHashCache[FTy] = Hash;
+	return Hash;
 }
 
 size_t hashIdxHash(size_t Hs, int Idx) {
-	hash<string> str_hash;
-	return Hs + str_hash(to_string(Idx));
+	return Hs + strHash(to_string(Idx));
 }
 
 size_t typeIdxHash(Type *Ty, int Idx) {
@@ -551,15 +822,13 @@ size_t typeIdxHash(Type *Ty, int Idx) {
 }
 
 size_t strIntHash(string str, int i) {
-	hash<string> str_hash;
 	// FIXME: remove pos
 	size_t pos = str.rfind("/");
-	return str_hash(str.substr(0, pos) + to_string(i));
+	return strHash(str.substr(0, pos) + to_string(i));
 }
 
 size_t moduleTypeHash(Module *M, size_t TyH) {
-	hash<string> str_hash;
-	return str_hash(M->getName().str() + to_string(TyH));
+	return strHash(M->getName().str() + to_string(TyH));
 }
 
 int64_t getGEPOffset(const Value *V, const DataLayout *DL) {
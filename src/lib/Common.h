@@ -68,6 +68,7 @@ extern cl::opt<unsigned> VerboseLevel;
 
 string getFileName(DILocation *Loc, 
 		DISubprogram *SP=NULL);
+string getSourcePath(string FN);
 
 bool isConstant(Value *V);
 
@@ -95,19 +96,39 @@ void getSourceCodeInfo(Value *V, string &file,
 int8_t getArgNoInCall(CallInst *CI, Value *Arg);
 Argument *getParamByArgNo(Function *F, int8_t ArgNo);
 
+bool materializeModule(Module *M);
+
+// Stable 64-bit hash of a string, the same across runs, hosts and
+// standard libraries; all hashes below build on it
+size_t strHash(StringRef Str);
+// Signature ID of a function type: equal for the types that a call
+// and its callee may have, see funcHash() and callHash()
+size_t sigHash(FunctionType *FTy);
 size_t funcHash(Function *F, bool withName = false);
 size_t callHash(CallInst *CI);
 void structTypeHash(StructType *STy, set<size_t> &HSet);
 size_t typeHash(Type *Ty);
+// Must be called before an LLVMContext whose types were hashed is freed
+void clearTypeHashCache();
 size_t typeIdxHash(Type *Ty, int Idx = -1);
 size_t hashIdxHash(size_t Hs, int Idx = -1);
 size_t strIntHash(string str, int i);
 size_t moduleTypeHash(Module *M, size_t TyH);
-string structTyStr(StructType *STy);
+// Shape of a struct, which an unnamed struct shares with the
+// identified structs it may stand for
+uint64_t structShapeHash(StructType *STy);
 bool trimPathSlash(string &path, int slash);
 int64_t getGEPOffset(const Value *V, const DataLayout *DL);
 void LoadElementsStructNameMap(
-		vector<pair<Module*, StringRef>> &Modules);
+		vector<pair<Module*, StringRef>> &Modules, unsigned NumThreads = 1);
+
+// With -shared-context, all modules are loaded into one LLVMContext,
+// which renames a struct to "<name>.<N>" if the name is already taken
+// by a struct of an earlier module. The following map such names back
+// to the original ones, so that types keep their identities.
+void detachStructNames(Module *M);
+void restoreStructNames();
+StringRef structName(StructType *STy);
 
 //
 // Common data structures
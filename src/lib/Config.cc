@@ -3,3 +3,4 @@
 int ENABLE_MLTA = 0;
 int ENABLE_TYDM = 1;
 int MAX_PHASE_CG = 2;
+string TARGET_TYPES_FILE = "";
@@ -25,6 +25,8 @@ using namespace llvm;
 extern int ENABLE_MLTA;
 extern int ENABLE_TYDM;
 extern int MAX_PHASE_CG;
+// File of target types; configs/critical-structs if empty
+extern string TARGET_TYPES_FILE;
 
 #define SOUND_MODE 1
 #define UNROLL_LOOP_ONCE 1
@@ -41,6 +43,8 @@ extern int MAX_PHASE_CG;
 ///////////////////////////////////////////////////////////
 
 #define MAX_TYPE_LAYER 10
+// Targets collected before they are merged, see TypeFieldFacts
+#define MAX_PENDING_TARGETS (1 << 20)
 //#define MAP_CALLER_TO_CALLEE 1
 //#define MLTA_FIELD_INSENSITIVE
 #define PRINT_SOURCE_LINE
@@ -143,16 +147,16 @@ static void LoadTraces(map<size_t, set<size_t>> &hashedTraces,
 
 static void LoadTargetTypes(set<size_t> &TTySet) {
 
-	hash<string> str_hash;
 	string exepath = sys::fs::getMainExecutable(NULL, NULL);
 	string exedir = exepath.substr(0, exepath.find_last_of('/'));
 	string line;
-	ifstream structfile(exedir + "/configs/critical-structs");
+	ifstream structfile(TARGET_TYPES_FILE != "" ? TARGET_TYPES_FILE :
+			exedir + "/configs/critical-structs");
 	if (structfile.is_open()) {
 		while (!structfile.eof()) {
 			getline (structfile, line);
 			if (line.length() > 1) {
-				TTySet.insert(str_hash("struct." + line));
+				TTySet.insert(strHash("struct." + line));
 			}
 		}
 		structfile.close();
@@ -162,7 +166,7 @@ static void LoadTargetTypes(set<size_t> &TTySet) {
 		"struct.ksm_scan",
 	};
 	for (auto name : TTyName) {
-		TTySet.insert(str_hash(name));
+		TTySet.insert(strHash(name));
 	}
 }
 
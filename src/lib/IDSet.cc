@@ -0,0 +1,82 @@
+//===-- IDSet.cc - Merge kernels of sorted ID sets --------------===//
+//
+// Unions and intersections of sorted arrays of IDs. The merge loops
+// are free of data-dependent branches: the comparisons of two callee
+// sets are hardly predictable, so they are turned into conditional
+// moves and index increments instead.
+//
+//===-----------------------------------------------------------===//
+
+#include "IDSet.h"
+
+using namespace llvm;
+
+void unionIDs(ArrayRef<uint32_t> A, ArrayRef<uint32_t> B,
+		SmallVectorImpl<uint32_t> &Out) {
+
+	size_t NA = A.size(), NB = B.size();
+	Out.resize(NA + NB);
+	const uint32_t *PA = A.data(), *PB = B.data();
+	uint32_t *PO = Out.data();
+
+	size_t i = 0, j = 0, k = 0;
+	while (i < NA && j < NB) {
+		uint32_t a = PA[i], b = PB[j];
+		PO[k++] = a < b ? a : b;
+		i += (a <= b);
+		j += (b <= a);
+	}
+	while (i < NA)
+		PO[k++] = PA[i++];
+	while (j < NB)
+		PO[k++] = PB[j++];
+	Out.resize(k);
+}
+
+void intersectIDs(ArrayRef<uint32_t> A, ArrayRef<uint32_t> B,
+		SmallVectorImpl<uint32_t> &Out) {
+
+	if (A.size() > B.size())
+		std::swap(A, B);
+	Out.clear();
+	if (A.empty())
+		return;
+
+	// When one set is much smaller, e.g., the targets of a field
+	// against the first-layer targets of a signature, search each of
+	// its IDs in the larger one, galloping from the previous match
+	if (A.size() * 32 < B.size()) {
+		const uint32_t *P = B.begin(), *E = B.end();
+		for (uint32_t ID : A) {
+			size_t Step = 1;
+			const uint32_t *Q = P;
+			while (Q < E && *Q < ID) {
+				P = Q + 1;
+				// Do not step past the end
+				Q += std::min<size_t>(Step, E - Q);
+				Step <<= 1;
+			}
+			P = std::lower_bound(P, Q < E ? Q + 1 : E, ID);
+			if (P == E)
+				break;
+			if (*P == ID)
+				Out.push_back(ID);
+		}
+		return;
+	}
+
+	size_t NA = A.size(), NB = B.size();
+	Out.resize(NA);
+	const uint32_t *PA = A.data(), *PB = B.data();
+	uint32_t *PO = Out.data();
+
+	size_t i = 0, j = 0, k = 0;
+	while (i < NA && j < NB) {
+		uint32_t a = PA[i], b = PB[j];
+		PO[k] = a;
+		k += (a == b);
+		i += (a <= b);
+		j += (b <= a);
+	}
+	Out.resize(k);
+}
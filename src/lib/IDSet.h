@@ -0,0 +1,245 @@
+#ifndef _ID_SET_H
+#define _ID_SET_H
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/Hashing.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallVector.h>
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <assert.h>
+#include <stdint.h>
+
+//
+// Sets of dense IDs, kept as sorted arrays. Unions and intersections
+// are linear merges over contiguous arrays, see IDSet.cc, instead of
+// probing a hash set element by element.
+//
+
+// Out = A | B; Out must not alias A or B
+void unionIDs(llvm::ArrayRef<uint32_t> A, llvm::ArrayRef<uint32_t> B,
+		llvm::SmallVectorImpl<uint32_t> &Out);
+// Out = A & B; Out must not alias A or B
+void intersectIDs(llvm::ArrayRef<uint32_t> A, llvm::ArrayRef<uint32_t> B,
+		llvm::SmallVectorImpl<uint32_t> &Out);
+
+// The elements of an IDSet are IDs themselves
+struct IdentityIDMap {
+	typedef unsigned value_type;
+	static uint32_t getID(unsigned V) { return V; }
+	static bool findID(unsigned V, uint32_t &ID) { ID = V; return true; }
+	static unsigned get(uint32_t ID) { return ID; }
+};
+
+//
+// A set of values by their dense IDs. MapTy maps a value to its ID
+// (getID), looks up the ID without assigning one (findID), and maps
+// the ID back (get); iteration is in the order of the IDs.
+//
+// A single insert() must append, i.e., come in the order of the IDs,
+// as inserting into the middle of the array takes linear time. Sets
+// built in any other order collect their elements first and add them
+// at once, see IDSetBuilder.
+//
+template <typename MapTy>
+class IDSet {
+
+	public:
+		typedef typename MapTy::value_type value_type;
+
+		class iterator {
+			friend class IDSet;
+			const uint32_t *P;
+
+			public:
+				typedef std::forward_iterator_tag iterator_category;
+				typedef typename MapTy::value_type value_type;
+				typedef std::ptrdiff_t difference_type;
+				typedef const value_type *pointer;
+				typedef value_type reference;
+
+				explicit iterator(const uint32_t *P_ = nullptr) : P(P_) { }
+
+				value_type operator*() const { return MapTy::get(*P); }
+				uint32_t getID() const { return *P; }
+				iterator &operator++() { ++P; return *this; }
+				iterator operator++(int) { iterator I = *this; ++P; return I; }
+				bool operator==(const iterator &I) const { return P == I.P; }
+				bool operator!=(const iterator &I) const { return P != I.P; }
+		};
+		typedef iterator const_iterator;
+
+		iterator begin() const { return iterator(IDs.begin()); }
+		iterator end() const { return iterator(IDs.end()); }
+		unsigned size() const { return IDs.size(); }
+		bool empty() const { return IDs.empty(); }
+		void clear() { IDs.clear(); }
+		llvm::ArrayRef<uint32_t> ids() const { return IDs; }
+		static uint32_t getID(value_type V) { return MapTy::getID(V); }
+
+		iterator find(value_type V) const {
+			uint32_t ID;
+			if (!MapTy::findID(V, ID))
+				return end();
+			const uint32_t *P = std::lower_bound(IDs.begin(), IDs.end(), ID);
+			if (P != IDs.end() && *P == ID)
+				return iterator(P);
+			return end();
+		}
+		unsigned count(value_type V) const { return find(V) != end(); }
+
+		// Add V, whose ID must not be below the IDs in the set
+		std::pair<iterator, bool> insert(value_type V) {
+			uint32_t ID = MapTy::getID(V);
+			if (!IDs.empty() && IDs.back() >= ID) {
+				assert(IDs.back() == ID && "IDSet::insert() out of order");
+				return std::make_pair(iterator(IDs.end() - 1), false);
+			}
+			IDs.push_back(ID);
+			return std::make_pair(iterator(IDs.end() - 1), true);
+		}
+		void insert(iterator First, iterator Last) {
+			insertIDs(llvm::ArrayRef<uint32_t>(First.P, Last.P));
+		}
+		template <typename It>
+		void insert(It First, It Last) {
+			llvm::SmallVector<uint32_t, 16> New;
+			for (; First != Last; ++First)
+				New.push_back(MapTy::getID(*First));
+			llvm::sort(New);
+			New.erase(std::unique(New.begin(), New.end()), New.end());
+			insertIDs(New);
+		}
+
+		bool erase(value_type V) {
+			iterator I = find(V);
+			if (I == end())
+				return false;
+			erase(I);
+			return true;
+		}
+		iterator erase(iterator I) {
+			uint32_t *P = IDs.begin() + (I.P - IDs.begin());
+			return iterator(IDs.erase(P));
+		}
+		template <typename PredTy>
+		bool remove_if(PredTy Pred) {
+			return removeIDsIf(
+					[&](uint32_t ID) { return Pred(MapTy::get(ID)); });
+		}
+		// As remove_if(), with the predicate on the IDs
+		template <typename PredTy>
+		bool removeIDsIf(PredTy Pred) {
+			unsigned Size = IDs.size();
+			IDs.erase(std::remove_if(IDs.begin(), IDs.end(), Pred),
+					IDs.end());
+			return IDs.size() != Size;
+		}
+
+		IDSet &operator|=(const IDSet &S) {
+			insertIDs(S.IDs);
+			return *this;
+		}
+		// Set to the intersection of A and B
+		void intersect(const IDSet &A, const IDSet &B) {
+			if (this == &A || this == &B) {
+				IDSet R;
+				R.intersect(A, B);
+				*this = std::move(R);
+				return;
+			}
+			intersectIDs(A.IDs, B.IDs, IDs);
+		}
+
+		bool operator==(const IDSet &S) const { return IDs == S.IDs; }
+		bool operator!=(const IDSet &S) const { return IDs != S.IDs; }
+		size_t hash() const {
+			return llvm::hash_combine_range(IDs.begin(), IDs.end());
+		}
+
+		// Add the IDs of S, which must be sorted and unique
+		void insertIDs(llvm::ArrayRef<uint32_t> S) {
+			if (S.empty())
+				return;
+			// Appending is the common case
+			if (IDs.empty() || IDs.back() < S.front()) {
+				IDs.append(S.begin(), S.end());
+				return;
+			}
+			llvm::SmallVector<uint32_t, 8> R;
+			unionIDs(IDs, S, R);
+			IDs = std::move(R);
+		}
+
+	private:
+		llvm::SmallVector<uint32_t, 8> IDs;
+};
+
+//
+// Collects the elements of an IDSet in any order; flush() sorts them
+// once and merges them into the set.
+//
+template <typename MapTy>
+class IDSetBuilder {
+
+	public:
+		void add(typename MapTy::value_type V) {
+			IDs.push_back(MapTy::getID(V));
+		}
+		bool empty() const { return IDs.empty(); }
+		void clear() { IDs.clear(); }
+
+		void flush(IDSet<MapTy> &S) {
+			llvm::sort(IDs);
+			IDs.erase(std::unique(IDs.begin(), IDs.end()), IDs.end());
+			S.insertIDs(IDs);
+			IDs.clear();
+		}
+
+	private:
+		std::vector<uint32_t> IDs;
+};
+
+//
+// Hash-consed immutable IDSets. Equal sets are stored once and shared
+// by their users, which hold a pointer to the pooled set; changing the
+// set of a user means interning the new set and replacing the pointer.
+// Pooled sets live as long as the pool.
+//
+template <typename MapTy>
+class IDSetPool {
+
+	public:
+		typedef IDSet<MapTy> SetTy;
+
+		IDSetPool() { Empty = intern(SetTy()); }
+		IDSetPool(const IDSetPool &) = delete;
+		IDSetPool &operator=(const IDSetPool &) = delete;
+
+		// The pooled set equal to S
+		const SetTy *intern(const SetTy &S) {
+			auto &Bucket = Buckets[S.hash()];
+			for (const SetTy *T : Bucket) {
+				if (*T == S)
+					return T;
+			}
+			Sets.push_back(S);
+			Bucket.push_back(&Sets.back());
+			return Bucket.back();
+		}
+		const SetTy *getEmpty() const { return Empty; }
+		// Number of distinct sets
+		unsigned size() const { return Sets.size(); }
+
+	private:
+		std::unordered_map<size_t, llvm::SmallVector<const SetTy *, 1>>
+			Buckets;
+		std::deque<SetTy> Sets;
+		const SetTy *Empty;
+};
+
+#endif
@@ -35,20 +35,50 @@
 
 using namespace llvm;
 
-map<Module *, Type *>MLTA::Int8PtrTy;
-
 //
 // Implementation
 //
 pair<Type *, int> typeidx_c(Type *Ty, int Idx) {
 	return make_pair(Ty, Idx);
 }
-pair<size_t, int> hashidx_c(size_t Hash, int Idx) {
-	return make_pair(Hash, Idx);
+
+unsigned TypeFieldIDs::getTypeID(size_t TyHash) {
+
+	auto It = TypeIDs.find(TyHash);
+	if (It != TypeIDs.end())
+		return It->second;
+
+	unsigned T = TypeFields.size();
+	TypeIDs[TyHash] = T;
+	TypeFields.emplace_back();
+	return T;
+}
+
+fieldid_t TypeFieldIDs::getFieldID(size_t TyHash, int Idx) {
+
+	unsigned T = getTypeID(TyHash);
+	auto It = FieldIDs.find(make_pair(T, Idx));
+	if (It != FieldIDs.end())
+		return It->second;
+
+	fieldid_t F = FieldTypes.size();
+	FieldIDs[make_pair(T, Idx)] = F;
+	FieldTypes.push_back(T);
+	FieldIdxs.push_back(Idx);
+	TypeFields[T].push_back(F);
+	return F;
+}
+
+void TypeFieldIDs::clear() {
+	TypeIDs.clear();
+	FieldIDs.clear();
+	TypeFields.clear();
+	FieldTypes.clear();
+	FieldIdxs.clear();
 }
 
 bool MLTA::fuzzyTypeMatch(Type *Ty1, Type *Ty2, 
-		Module *M1, Module *M2) {
+		ModuleInfo &MI1, ModuleInfo &MI2) {
 
 	if (Ty1 == Ty2)
 		return true;
@@ -59,7 +89,8 @@ bool MLTA::fuzzyTypeMatch(Type *Ty1, Type *Ty2,
 	}
 
 	if (Ty1->isStructTy() && Ty2->isStructTy() &&
-			(Ty1->getStructName().equals(Ty2->getStructName())))
+			structName(cast<StructType>(Ty1)).equals(
+				structName(cast<StructType>(Ty2))))
 		return true;
 	if (Ty1->isIntegerTy() && Ty2->isIntegerTy() &&
 			Ty1->getIntegerBitWidth() == Ty2->getIntegerBitWidth())
@@ -69,12 +100,14 @@ bool MLTA::fuzzyTypeMatch(Type *Ty1, Type *Ty2,
 	// Make the type analysis conservative: assume general
 	// pointers, i.e., "void *" and "char *", are equivalent to 
 	// any pointer type and integer type.
+	Type *Int8PtrTy1 = MI1.Int8PtrTy;
+	Type *IntPtrTy2 = MI2.IntPtrTy;
 	if (
-			(Ty1 == Int8PtrTy[M1] &&
-			 (Ty2->isPointerTy() || Ty2 == IntPtrTy[M2])) 
+			(Ty1 == Int8PtrTy1 &&
+			 (Ty2->isPointerTy() || Ty2 == IntPtrTy2)) 
 			||
-			(Ty2 == Int8PtrTy[M1] &&
-			 (Ty1->isPointerTy() || Ty1 == IntPtrTy[M2]))
+			(Ty2 == Int8PtrTy1 &&
+			 (Ty1->isPointerTy() || Ty1 == IntPtrTy2))
 	   )
 		return true;
 
@@ -95,15 +128,16 @@ void MLTA::findCalleesWithType(CallInst *CI, FuncSet &S) {
 	// Performance improvement: cache results for types
 	//
 	size_t CIH = callHash(CI);
-	if (MatchedFuncsMap.find(CIH) != MatchedFuncsMap.end()) {
-		if (!MatchedFuncsMap[CIH].empty())
-			S.insert(MatchedFuncsMap[CIH].begin(), 
-					MatchedFuncsMap[CIH].end());
+	auto It = MatchedFuncsMap.find(CIH);
+	if (It != MatchedFuncsMap.end()) {
+		S |= *It->second;
 		return;
 	}
 
 	CallBase *CB = dyn_cast<CallBase>(CI);
-	for (Function *F : Ctx->AddressTakenFuncs) {
+	ModuleInfo &CallerMI = getModuleInfo(CI->getModule());
+	for (uint32_t FID : Ctx->AddressTakenFuncs.ids()) {
+		Function *F = FuncIDMap::get(FID);
 		// VarArg
 		if (F->getFunctionType()->isVarArg()) {
 			// Compare only known args in VarArg.
@@ -118,13 +152,12 @@ void MLTA::findCalleesWithType(CallInst *CI, FuncSet &S) {
 		}
 
 		// Types completely match
-		if (callHash(CI) == funcHash(F)) {
+		if (CIH == sigHash(F->getFunctionType())) {
 			S.insert(F);
 			continue;
 		}
 
-		Module *CalleeM = F->getParent();
-		Module *CallerM = CI->getFunction()->getParent();
+		ModuleInfo &CalleeMI = getModuleInfo(Ctx->getFuncModuleID(FID));
 
 		// Type matching on args.
 		bool Matched = true;
@@ -138,7 +171,7 @@ void MLTA::findCalleesWithType(CallInst *CI, FuncSet &S) {
 			// Get actual type on caller side.
 			Type *ActualTy = (*AI)->getType();
 
-			if (!fuzzyTypeMatch(DefinedTy, ActualTy, CalleeM, CallerM)) {
+			if (!fuzzyTypeMatch(DefinedTy, ActualTy, CalleeMI, CallerMI)) {
 				Matched = false;
 				break;
 			}
@@ -148,7 +181,7 @@ void MLTA::findCalleesWithType(CallInst *CI, FuncSet &S) {
 		if (Matched) {
 			Type *RTy1 = F->getReturnType();
 			Type *RTy2 = CI->getType();
-			if (!fuzzyTypeMatch(RTy1, RTy2, CalleeM, CallerM)) {
+			if (!fuzzyTypeMatch(RTy1, RTy2, CalleeMI, CallerMI)) {
 				Matched = false;
 			}
 		}
@@ -157,7 +190,7 @@ void MLTA::findCalleesWithType(CallInst *CI, FuncSet &S) {
 			S.insert(F);
 		}
 	}
-	MatchedFuncsMap[CIH] = S;
+	MatchedFuncsMap[CIH] = Ctx->CalleeSets.intern(S);
 }
 
 
@@ -278,8 +311,7 @@ Type *MLTA::getFuncPtrType(Value *V) {
 
 Value *MLTA::recoverBaseType(Value *V) {
 	if (Instruction *I = dyn_cast<Instruction>(V)) {
-		map<Value *, Value *> &AliasMap 
-			= AliasStructPtrMap[I->getFunction()];
+		auto &AliasMap = AliasStructPtrMap[I->getFunction()];
 		if (AliasMap.find(V) != AliasMap.end()) {
 			return AliasMap[V];
 		}
@@ -418,6 +450,7 @@ bool MLTA::typeConfineInInitializer(GlobalVariable *GV) {
 
 	list<pair<Type *, int>>NestedInit;
 	map<Value *, pair<Value *, int>>ContainersMap;
+	FuncSetBuilder VTableFuncs;
 	set<Value *>FuncOperands;
 	list<User *>LU;
 	set<Value *>Visited;
@@ -485,7 +518,7 @@ bool MLTA::typeConfineInInitializer(GlobalVariable *GV) {
 					Type *ITy = U->getType();
 					// FIXME: Assume this is VTable
 					if (!ITy->isStructTy()) {
-						VTableFuncsMap[GV].insert(CF);
+						VTableFuncs.add(CF);
 					}
 
 					FoundF = CF;
@@ -510,7 +543,7 @@ bool MLTA::typeConfineInInitializer(GlobalVariable *GV) {
 					Type *Ty = POTy->getPointerElementType();
 					// FIXME: take it as a confinement instead of a cap
 					if (Ty->isStructTy())
-						typeCapSet.insert(typeHash(Ty));
+						capType(Ty);
 				}
 			}
 			else {
@@ -523,7 +556,7 @@ bool MLTA::typeConfineInInitializer(GlobalVariable *GV) {
 				// "llvm.compiler.used" indicates that the linker may touch
 				// it, so do not apply MLTA against them
 				if (GV->getName() != "llvm.compiler.used")
-					StoredFuncs.insert(FoundF);
+					NewStoredFuncs.add(FoundF);
 
 				// Add the function type to all containers
 				Value *CV = O;
@@ -532,27 +565,11 @@ bool MLTA::typeConfineInInitializer(GlobalVariable *GV) {
 					auto Container = ContainersMap[CV];
 
 					Type *CTy = Container.first->getType();
-					set<size_t> TyHS;
-					if (StructType *STy = dyn_cast<StructType>(CTy)) {
-						structTypeHash(STy, TyHS);
-					}
-					else
-						TyHS.insert(typeHash(CTy));
-
-					DBG<<"[INSERT-INIT] Container type: "<<*CTy
-						<<"; Idx: "<<Container.second
-						<<"\n\t --> FUNC: "<<FoundF->getName()<<"; Module: "
-						<<FoundF->getParent()->getName()<<"\n";
-
-					for (auto TyH : TyHS) {
 #ifdef MLTA_FIELD_INSENSITIVE 
-						typeIdxFuncsMap[TyH][0].insert(FoundF);
+					confineInitializerTarget(CTy, 0, FoundF);
 #else
-						typeIdxFuncsMap[TyH][Container.second].insert(FoundF);
+					confineInitializerTarget(CTy, Container.second, FoundF);
 #endif
-						DBG<<"[HASH] "<<TyH<<"\n";
-
-					}
 
 					Visited.insert(CV);
 					if (Visited.find(Container.first) != Visited.end())
@@ -563,6 +580,8 @@ bool MLTA::typeConfineInInitializer(GlobalVariable *GV) {
 			}
 		}
 	}
+	if (!VTableFuncs.empty())
+		VTableFuncs.flush(VTableFuncsMap[GV]);
 
 	return true;
 }
@@ -604,17 +623,7 @@ bool MLTA::typeConfineInFunction(Function *F) {
 					Function *CF = dyn_cast<Function>(CV);
 					if (!CF)
 						continue;
-					if (CF->isDeclaration())
-						CF = Ctx->GlobalFuncMap[CF->getGUID()];
-					if (!CF)
-						continue;
-					if (Argument *Arg = getParamByArgNo(CF, OI->getOperandNo())) {
-						for (auto U : Arg->users()) {
-							if (isa<StoreInst>(U) || isa<BitCastOperator>(U)) {
-								confineTargetFunction(U, F);
-							}
-						}
-					}
+					confineArgTarget(CF, OI->getOperandNo(), F);
 					// TODO: track into the callee to avoid marking the
 					// function type as a cap
 				}
@@ -662,7 +671,7 @@ bool MLTA::typePropInFunction(Function *F) {
 			if (isa<ConstantAggregate>(VO) || isa<ConstantData>(VO))
 				continue;
 
-			list<typeidx_t>TyList;
+			TypeIdxList TyList;
 			Value *NextV = NULL;
 			set<Value *> Visited;
 			nextLayerBaseType(VO, TyList, NextV, Visited);
@@ -741,9 +750,9 @@ bool MLTA::typePropInFunction(Function *F) {
 }
 
 // This function precisely collects alias types for general pointers
-void MLTA::collectAliasStructPtr(Function *F) {
+void MLTA::collectAliasStructPtr(Function *F, ModuleInfo &MI) {
 
-	map<Value *, Value *> &AliasMap = AliasStructPtrMap[F];
+	auto &AliasMap = AliasStructPtrMap[F];
 	set<Value *>ToErase;
 	for (inst_iterator i = inst_begin(F), e = inst_end(F); 
 			i != e; ++i) {
@@ -758,7 +767,7 @@ void MLTA::collectAliasStructPtr(Function *F) {
 
 			Type *FromTy = FromV->getType();
 			Type *ToTy = CI->getType();
-			if (Int8PtrTy[F->getParent()] != FromTy)
+			if (MI.Int8PtrTy != FromTy)
 				continue;
 
 			if (!ToTy->isPointerTy())
@@ -781,12 +790,12 @@ void MLTA::collectAliasStructPtr(Function *F) {
 
 void MLTA::escapeType(Value *V) {
 
-	list<typeidx_t> TyChain;
+	TypeIdxList TyChain;
 	bool Complete = true;
 	getBaseTypeChain(TyChain, V, Complete);
 	for (auto T : TyChain) {
 		DBG<<"[Escape] Type: "<<*(T.first)<<"; Idx: "<<T.second<<"\n";
-		typeEscapeSet.insert(typeIdxHash(T.first, T.second));
+		typeFacts.escape(typeFacts.getField(typeHash(T.first), T.second));
 	}
 }
 
@@ -794,9 +803,9 @@ void MLTA::confineTargetFunction(Value *V, Function *F) {
 	if (F->isIntrinsic())
 		return;
 
-	StoredFuncs.insert(F);
+	NewStoredFuncs.add(F);
 
-	list<typeidx_t> TyChain;
+	TypeIdxList TyChain;
 	bool Complete = true;
 	getBaseTypeChain(TyChain, V, Complete);
 	for (auto TI : TyChain) {
@@ -804,19 +813,59 @@ void MLTA::confineTargetFunction(Value *V, Function *F) {
 			<<"\n\t --> FUNC:  "<<F->getName()<<"; Module: "
 			<<F->getParent()->getName()<<"\n";
 		DBG<<"[HASH] "<<typeHash(TI.first)<<"\n";
-		typeIdxFuncsMap[typeHash(TI.first)][TI.second].insert(F);
+		typeFacts.addTarget(typeHash(TI.first), TI.second, F);
 	}
 	if (!Complete) {
 		if (!TyChain.empty())
-			typeCapSet.insert(typeHash(TyChain.back().first));
+			typeFacts.cap(typeHash(TyChain.back().first));
 		else
-			typeCapSet.insert(funcHash(F));
+			typeFacts.cap(funcHash(F));
+	}
+}
+
+void MLTA::capType(Type *Ty) {
+	typeFacts.cap(typeHash(Ty));
+}
+
+void MLTA::confineInitializerTarget(Type *CTy, int Idx, Function *F) {
+
+	set<size_t> TyHS;
+	if (StructType *STy = dyn_cast<StructType>(CTy)) {
+		structTypeHash(STy, TyHS);
+	}
+	else
+		TyHS.insert(typeHash(CTy));
+
+	DBG<<"[INSERT-INIT] Container type: "<<*CTy
+		<<"; Idx: "<<Idx
+		<<"\n\t --> FUNC: "<<F->getName()<<"; Module: "
+		<<F->getParent()->getName()<<"\n";
+
+	for (auto TyH : TyHS) {
+		typeFacts.addTarget(TyH, Idx, F);
+		DBG<<"[HASH] "<<TyH<<"\n";
+	}
+}
+
+// F is confined to the types the arg of CF is stored or cast to
+void MLTA::confineArgTarget(Function *CF, unsigned OpNo, Function *F) {
+
+	if (CF->isDeclaration())
+		CF = Ctx->getFuncDef(CF);
+	if (!CF)
+		return;
+	if (Argument *Arg = getParamByArgNo(CF, OpNo)) {
+		for (auto U : Arg->users()) {
+			if (isa<StoreInst>(U) || isa<BitCastOperator>(U)) {
+				confineTargetFunction(U, F);
+			}
+		}
 	}
 }
 
 void MLTA::propagateType(Value *ToV, Type *FromTy, int Idx) {
 
-	list<typeidx_t> TyChain;
+	TypeIdxList TyChain;
 	bool Complete = true;
 	getBaseTypeChain(TyChain, ToV, Complete);
 	for (auto T : TyChain) {
@@ -824,8 +873,8 @@ void MLTA::propagateType(Value *ToV, Type *FromTy, int Idx) {
 		if (typeHash(T.first) == typeHash(FromTy) && T.second == Idx)
 			continue;
 
-		typeIdxPropMap[typeHash(T.first)]
-			[T.second].insert(hashidx_c(typeHash(FromTy), Idx));
+		typeFacts.addProp(typeFacts.getField(typeHash(T.first), T.second),
+				typeFacts.getField(typeHash(FromTy), Idx));
 		DBG<<"[PROP] "<<*(FromTy)<<": "<<Idx
 			<<"\n\t===> "<<*(T.first)<<" "<<T.second<<"\n";
 	}
@@ -833,11 +882,7 @@ void MLTA::propagateType(Value *ToV, Type *FromTy, int Idx) {
 
 void MLTA::intersectFuncSets(FuncSet &FS1, FuncSet &FS2, 
 		FuncSet &FS) {
-	FS.clear();
-	for (auto F : FS1) {
-		if (FS2.find(F) != FS2.end())
-			FS.insert(F);
-	}
+	FS.intersect(FS1, FS2);
 }
 
 Value *MLTA::getVTable(Value *V) {
@@ -898,11 +943,11 @@ void MLTA::saveCalleesInfo(CallInst *CI, FuncSet &FS,
 	}
 }
 
-void MLTA::printTypeChain(list<typeidx_t> &Chain) {
+void MLTA::printTypeChain(TypeIdxList &Chain) {
 	if (Chain.empty())
 		return;
 
-	for (list<typeidx_t>::iterator it = Chain.begin(); 
+	for (TypeIdxList::iterator it = Chain.begin(); 
 			it != Chain.end(); ++it) {
 		typeidx_t TI = *it;
 		OP<<"--<"<<*(TI.first)<<", "<<TI.second<<">";
@@ -910,7 +955,7 @@ void MLTA::printTypeChain(list<typeidx_t> &Chain) {
 	OP<<"\n";
 }
 
-void MLTA::printTargets(FuncSet &FS, CallInst *CI) {
+void MLTA::printTargets(const FuncSet &FS, CallInst *CI) {
 
 	if (CI) {
 #ifdef PRINT_SOURCE_LINE
@@ -942,12 +987,12 @@ void MLTA::printTargets(FuncSet &FS, CallInst *CI) {
 // Get the chain of base types for V
 // Complete: whether the chain's end is not escaping---it won't
 // propagate further
-bool MLTA::getBaseTypeChain(list<typeidx_t> &Chain, Value *V,
+bool MLTA::getBaseTypeChain(TypeIdxList &Chain, Value *V,
 		bool &Complete) {
 
 	Complete = true;
 	Value *CV = V, *NextV = NULL;
-	list<typeidx_t> TyList;
+	TypeIdxList TyList;
 	set<Value *>Visited;
 
 	Type *BTy = getBaseType(V, Visited);
@@ -984,7 +1029,7 @@ bool MLTA::getBaseTypeChain(list<typeidx_t> &Chain, Value *V,
 	}
 
 	if (!Chain.empty() && !Complete) {
-		typeCapSet.insert(typeHash(Chain.back().first));
+		typeFacts.cap(typeHash(Chain.back().first));
 	}
 
 	return true;
@@ -1057,13 +1102,13 @@ Type *MLTA::_getPhiBaseType(PHINode *PN, set<Value *> &Visited) {
 	return NULL;
 }
 
-bool MLTA::getGEPLayerTypes(GEPOperator *GEP, list<typeidx_t> &TyList) {
+bool MLTA::getGEPLayerTypes(GEPOperator *GEP, TypeIdxList &TyList) {
 
 	Value *PO = GEP->getPointerOperand();
 	Type *ETy = GEP->getSourceElementType();
 
 	vector<int> Indices; 
-	list<typeidx_t> TmpTyList;
+	TypeIdxList TmpTyList;
 	// FIXME: handle downcasting: the GEP may get a field outside the
 	// base type
 	// Or use O0 to avoid this issue
@@ -1105,8 +1150,8 @@ bool MLTA::getGEPLayerTypes(GEPOperator *GEP, list<typeidx_t> &TyList) {
 				APInt Offset (ConstI->getBitWidth(), 
 						ConstI->getZExtValue());
 				Type *BaseTy = ETy;
-				SmallVector<APInt>IndiceV = DLMap[I->getModule()]
-					->getGEPIndicesForOffset(BaseTy, Offset);
+				SmallVector<APInt>IndiceV = I->getModule()->getDataLayout()
+					.getGEPIndicesForOffset(BaseTy, Offset);
 				for (auto Idx : IndiceV) {
 					Indices.push_back(*Idx.getRawData());
 				}
@@ -1182,7 +1227,7 @@ bool MLTA::getGEPLayerTypes(GEPOperator *GEP, list<typeidx_t> &TyList) {
 		return false;
 }
 
-bool MLTA::nextLayerBaseTypeWL(Value *V, list<typeidx_t> &TyList,
+bool MLTA::nextLayerBaseTypeWL(Value *V, TypeIdxList &TyList,
 		Value * &NextV) {
 
 	list<Value *> VL;
@@ -1249,7 +1294,7 @@ bool MLTA::nextLayerBaseTypeWL(Value *V, list<typeidx_t> &TyList,
 
 // Get the composite type of the lower layer. Layers are split by
 // memory loads or GEP
-bool MLTA::nextLayerBaseType(Value *V, list<typeidx_t> &TyList, 
+bool MLTA::nextLayerBaseType(Value *V, TypeIdxList &TyList, 
 		Value * &NextV, set<Value *> &Visited) {
 
 	if (!V || isa<Argument>(V)) {
@@ -1289,7 +1334,7 @@ bool MLTA::nextLayerBaseType(Value *V, list<typeidx_t> &TyList,
 		// FIXME: tracking incoming values
 		bool ret = false;
 		set<Value *> NVisited;
-		list<typeidx_t> NTyList;
+		TypeIdxList NTyList;
 		for (unsigned i = 0, e = PN->getNumIncomingValues(); i != e; ++i) {
 			Value *IV = PN->getIncomingValue(i);
 			NextV = IV;
@@ -1322,30 +1367,10 @@ bool MLTA::nextLayerBaseType(Value *V, list<typeidx_t> &TyList,
 	return false;
 }
 
-bool MLTA::getDependentTypes(Type *Ty, int Idx, 
-		set<hashidx_t> &PropSet) {
+bool MLTA::getDependentTypes(fieldid_t F, 
+		DenseSet<fieldid_t> &PropSet) {
 
-	list<hashidx_t>LT;
-	LT.push_back(hashidx_c(typeHash(Ty), Idx));
-	set<hashidx_t>Visited;
-
-	while (!LT.empty()) {
-		hashidx_t TI = LT.front();
-		LT.pop_front();
-		if (Visited.find(TI) != Visited.end()) {
-			continue;
-		}
-		Visited.insert(TI);
-
-		for (auto Prop : typeIdxPropMap[TI.first][TI.second]) {
-			PropSet.insert(Prop);
-			LT.push_back(Prop);
-		}
-		for (auto Prop : typeIdxPropMap[TI.first][-1]) {
-			PropSet.insert(Prop);
-			LT.push_back(Prop);
-		}
-	}
+	typeFacts.getDependentFields(F, PropSet);
 	return true;
 }
 
@@ -1369,22 +1394,12 @@ Function *MLTA::getBaseFunction(Value *V) {
 }
 
 // Get all possible targets of the given type
-bool MLTA::getTargetsWithLayerType(size_t TyHash, int Idx, 
-		FuncSet &FS) {
+bool MLTA::getTargetsWithLayerType(fieldid_t F, FuncSet &FS) {
 
 	// Get the direct funcset in the current layer, which
 	// will be further unioned with other targets from type
 	// casting
-	if (Idx == -1) {
-		for (auto FSet : typeIdxFuncsMap[TyHash]) {
-			FS.insert(FSet.second.begin(), FSet.second.end());
-		}
-	}
-	else {
-		FS = typeIdxFuncsMap[TyHash][Idx];
-		FS.insert(typeIdxFuncsMap[TyHash][-1].begin(), 
-				typeIdxFuncsMap[TyHash][-1].end());
-	}
+	typeFacts.getTargets(F, FS);
 
 	return true;
 }
@@ -1413,7 +1428,7 @@ bool MLTA::findCalleesWithMLTA(CallInst *CI,
 	int LayerNo = 1;
 
 	// Get the next-layer type
-	list<typeidx_t> TyList;
+	TypeIdxList TyList;
 	bool  ContinueNextLayer = true;
 	while (ContinueNextLayer) {
 
@@ -1422,7 +1437,7 @@ bool MLTA::findCalleesWithMLTA(CallInst *CI,
 			break;
 
 #ifdef SOUND_MODE
-		if (typeCapSet.find(typeHash(PrevLayerTy)) != typeCapSet.end()) {
+		if (typeFacts.isCap(typeHash(PrevLayerTy))) {
 			break;
 		}
 #endif
@@ -1446,24 +1461,24 @@ bool MLTA::findCalleesWithMLTA(CallInst *CI,
 				<<"; Idx: "<<TyIdx.second<<"\n";
 			DBG<<"[HASH] "<<typeHash(TyIdx.first)<<"\n";
 
-			size_t TyIdxHash = typeIdxHash(TyIdx.first, TyIdx.second);
+			size_t TyH = typeHash(TyIdx.first);
+			fieldid_t TyIdxF = typeFacts.getField(TyH, TyIdx.second);
 			// -1 represents all possible fields of a struct
-			size_t TyIdxHash_1 = typeIdxHash(TyIdx.first, -1);
+			fieldid_t TyIdxF_1 = typeFacts.getField(TyH, -1);
 
 			// Caching for performance
-			if (MatchedFuncsMap.find(TyIdxHash) != MatchedFuncsMap.end()) {
-				FS1 = MatchedFuncsMap[TyIdxHash];
+			if (MatchedFieldFuncsMap.find(TyIdxF) 
+					!= MatchedFieldFuncsMap.end()) {
+				FS1 = MatchedFieldFuncsMap[TyIdxF];
 			}
 			else {
 
 #ifdef SOUND_MODE
-				if (typeEscapeSet.find(TyIdxHash) 
-						!= typeEscapeSet.end()) {
+				if (typeFacts.isEscaped(TyIdxF)) {
 
 					break;
 				}
-				if (typeEscapeSet.find(TyIdxHash_1) 
-						!= typeEscapeSet.end()) {
+				if (typeFacts.isEscaped(TyIdxF_1)) {
 					break;
 				}
 #endif
@@ -1486,17 +1501,17 @@ bool MLTA::findCalleesWithMLTA(CallInst *CI,
 				}
 #endif
 
-				getTargetsWithLayerType(typeHash(TyIdx.first), TyIdx.second, FS1);
+				getTargetsWithLayerType(TyIdxF, FS1);
 
 				// Collect targets from dependent types that may propagate
 				// targets to it
-				set<hashidx_t> PropSet;
-				getDependentTypes(TyIdx.first, TyIdx.second, PropSet);
+				DenseSet<fieldid_t> PropSet;
+				getDependentTypes(TyIdxF, PropSet);
 				for (auto Prop : PropSet) {
-					getTargetsWithLayerType(Prop.first, Prop.second, FS2);
-					FS1.insert(FS2.begin(), FS2.end());
+					getTargetsWithLayerType(Prop, FS2);
+					FS1 |= FS2;
 				}
-				MatchedFuncsMap[TyIdxHash] = FS1;
+				MatchedFieldFuncsMap[TyIdxF] = FS1;
 			}
 
 			// Next layer may not always have a subset of the previous layer
@@ -1507,7 +1522,7 @@ bool MLTA::findCalleesWithMLTA(CallInst *CI,
 			CV = NextV;
 
 #ifdef SOUND_MODE
-			if (typeCapSet.find(typeHash(TyIdx.first)) != typeCapSet.end()) {
+			if (typeFacts.isCap(TyH)) {
 				ContinueNextLayer = false;
 				break;
 			}
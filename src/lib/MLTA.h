@@ -3,12 +3,209 @@
 
 #include "Analyzer.h"
 #include "Config.h"
+#include "Arena.h"
 #include "llvm/IR/Operator.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseSet.h"
 
 typedef pair<Type *, int> typeidx_t;
 pair<Type *, int> typeidx_c(Type *Ty, int Idx);
-typedef pair<size_t, int> hashidx_t;
-pair<size_t, int> hashidx_c(size_t Hash, int Idx);
+// Layer types of a value; only for use within the analysis of a
+// function, see FunctionArena
+typedef ArenaList<typeidx_t, FunctionArena> TypeIdxList;
+
+// Dense ID of a (type hash, field index) pair
+typedef unsigned fieldid_t;
+
+//
+// Dense numbering of type hashes and of their fields; index -1 stands
+// for all fields of a type. IDs are handed out on first use.
+//
+class TypeFieldIDs {
+
+	public:
+		unsigned getTypeID(size_t TyHash);
+		fieldid_t getFieldID(size_t TyHash, int Idx);
+		// The field of a type, or -1 if it has no ID yet
+		int findFieldID(unsigned T, int Idx) {
+			auto It = FieldIDs.find(make_pair(T, Idx));
+			return It == FieldIDs.end() ? -1 : (int)It->second;
+		}
+
+		unsigned getFieldType(fieldid_t F) { return FieldTypes[F]; }
+		int getFieldIdx(fieldid_t F) { return FieldIdxs[F]; }
+		// All fields of a type seen so far
+		const SmallVectorImpl<fieldid_t> &getTypeFields(unsigned T) {
+			return TypeFields[T];
+		}
+		unsigned getNumTypes() { return TypeFields.size(); }
+		unsigned getNumFields() { return FieldTypes.size(); }
+		void clear();
+
+	private:
+		DenseMap<size_t, unsigned> TypeIDs;
+		DenseMap<pair<unsigned, int>, fieldid_t> FieldIDs;
+		vector<SmallVector<fieldid_t, 4>> TypeFields;
+		vector<unsigned> FieldTypes;
+		vector<int> FieldIdxs;
+};
+
+//
+// The type facts of MLTA in flat tables: targets confined to each
+// field, fields propagated to each field, escaped fields, and cap
+// types. SetTy is the set of targets.
+//
+template <typename SetTy>
+class TypeFieldFacts {
+
+	public:
+		TypeFieldIDs IDs;
+		// Targets confined to each field
+		vector<SetTy> FieldTargets;
+
+		fieldid_t getField(size_t TyHash, int Idx) {
+			fieldid_t F = IDs.getFieldID(TyHash, Idx);
+			if (F >= FieldTargets.size()) {
+				FieldTargets.resize(F + 1);
+				FieldProps.resize(F + 1);
+				EscapedFields.resize(F + 1);
+			}
+			return F;
+		}
+		unsigned getType(size_t TyHash) {
+			unsigned T = IDs.getTypeID(TyHash);
+			if (T >= CapTypes.size())
+				CapTypes.resize(T + 1);
+			return T;
+		}
+
+		// Add V to the targets of a field. Targets come in no order,
+		// so they are collected and merged into the sets at once, see
+		// flushTargets()
+		void addTarget(fieldid_t F, typename SetTy::value_type V) {
+			PendingTargets.push_back(make_pair(F, SetTy::getID(V)));
+			if (PendingTargets.size() >= MAX_PENDING_TARGETS)
+				flushTargets();
+		}
+		void addTarget(size_t TyHash, int Idx, typename SetTy::value_type V) {
+			addTarget(getField(TyHash, Idx), V);
+		}
+		void flushTargets() {
+			if (PendingTargets.empty())
+				return;
+			llvm::sort(PendingTargets);
+			SmallVector<uint32_t, 16> IDs;
+			for (size_t i = 0; i < PendingTargets.size(); ) {
+				fieldid_t F = PendingTargets[i].first;
+				IDs.clear();
+				for (; i < PendingTargets.size()
+						&& PendingTargets[i].first == F; ++i) {
+					if (IDs.empty() || IDs.back() != PendingTargets[i].second)
+						IDs.push_back(PendingTargets[i].second);
+				}
+				FieldTargets[F].insertIDs(IDs);
+			}
+			PendingTargets.clear();
+		}
+		void addProp(fieldid_t To, fieldid_t From) {
+			if (PropPairs.insert(make_pair(To, From)).second)
+				FieldProps[To].push_back(From);
+		}
+		void escape(fieldid_t F) { EscapedFields.set(F); }
+		bool isEscaped(fieldid_t F) { return EscapedFields.test(F); }
+		void cap(size_t TyHash) { CapTypes.set(getType(TyHash)); }
+		bool isCap(size_t TyHash) { return CapTypes.test(getType(TyHash)); }
+
+		// Targets of a field. Those of all fields are added for index
+		// -1; otherwise FS is set to the targets of the field and of
+		// index -1.
+		void getTargets(fieldid_t F, SetTy &FS) {
+			flushTargets();
+			unsigned T = IDs.getFieldType(F);
+			if (IDs.getFieldIdx(F) == -1) {
+				for (fieldid_t G : IDs.getTypeFields(T))
+					FS |= FieldTargets[G];
+				return;
+			}
+			FS = FieldTargets[F];
+			int A = IDs.findFieldID(T, -1);
+			if (A != -1)
+				FS |= FieldTargets[A];
+		}
+
+		// Fields that may propagate targets to a field, transitively;
+		// a field propagates to index -1 as well
+		void getDependentFields(fieldid_t F, DenseSet<fieldid_t> &PropSet) {
+			SmallVector<fieldid_t, 16> Worklist;
+			DenseSet<fieldid_t> Visited;
+			Worklist.push_back(F);
+			while (!Worklist.empty()) {
+				fieldid_t G = Worklist.pop_back_val();
+				if (!Visited.insert(G).second)
+					continue;
+				for (fieldid_t P : FieldProps[G]) {
+					PropSet.insert(P);
+					Worklist.push_back(P);
+				}
+				int A = IDs.findFieldID(IDs.getFieldType(G), -1);
+				if (A == -1 || (fieldid_t)A == G)
+					continue;
+				for (fieldid_t P : FieldProps[A]) {
+					PropSet.insert(P);
+					Worklist.push_back(P);
+				}
+			}
+		}
+
+		void clear() {
+			IDs.clear();
+			FieldTargets.clear();
+			PendingTargets.clear();
+			FieldProps.clear();
+			PropPairs.clear();
+			EscapedFields.clear();
+			CapTypes.clear();
+		}
+
+	private:
+		// Targets not merged into FieldTargets yet, as (field, ID)
+		vector<pair<fieldid_t, uint32_t>> PendingTargets;
+		vector<SmallVector<fieldid_t, 2>> FieldProps;
+		DenseSet<pair<fieldid_t, fieldid_t>> PropPairs;
+		BitVector EscapedFields;
+		// Cap type: We cannot know where the type can be futher
+		// propagated to. Indexed by type ID, not field ID
+		BitVector CapTypes;
+};
+
+// TyPM: a store that may write a critical data structure, i.e., an
+// object of a target type or one behind a general pointer, with the
+// outermost target type and field it writes, if any
+struct StoreRecord {
+	Type *TTy;
+	int Idx;
+	bool Critical;
+};
+
+//
+// Facts of a module, indexed by the ID of the module, see
+// GlobalContext::ModuleIDs
+//
+struct ModuleInfo {
+	const DataLayout *DL = NULL;
+	// General pointer types like char * and void *
+	Type *Int8PtrTy = NULL;
+	// long interger type
+	Type *IntPtrTy = NULL;
+
+	// TyPM: which fields of a type have been stored to
+	ArenaMap<Type *, ArenaSet<int, RunArena>, RunArena> StoredTypeIdx;
+	// TyPM: all casts in the module
+	ArenaMap<Type *, ArenaSet<Type *, RunArena>, RunArena> CastFrom;
+	ArenaMap<Type *, ArenaSet<Type *, RunArena>, RunArena> CastTo;
+	// TyPM: stores to resolve, see TyPM::resolveStructTargets()
+	vector<StoreRecord> Stores;
+};
 
 class MLTA {
 
@@ -25,19 +222,16 @@ class MLTA {
 		// Important data structures for type confinement, propagation,
 		// and escapes. 
 		////////////////////////////////////////////////////////////////
-		DenseMap<size_t, map<int, FuncSet>>typeIdxFuncsMap;
-		map<size_t, map<int, set<hashidx_t>>>typeIdxPropMap;
-		set<size_t>typeEscapeSet;
-		// Cap type: We cannot know where the type can be futher
-		// propagated to. Do not include idx in the hash
-		set<size_t>typeCapSet;
+		TypeFieldFacts<FuncSet> typeFacts;
 
 
 		////////////////////////////////////////////////////////////////
 		// Other data structures
 		////////////////////////////////////////////////////////////////
 		// Cache matched functions for CallInst
-		DenseMap<size_t, FuncSet>MatchedFuncsMap;
+		DenseMap<size_t, const FuncSet *>MatchedFuncsMap;
+		// Cache matched functions for a layer type
+		DenseMap<fieldid_t, FuncSet>MatchedFieldFuncsMap;
 		DenseMap<Value *, FuncSet>VTableFuncsMap;
 
 		set<size_t>srcLnHashSet;
@@ -52,11 +246,14 @@ class MLTA {
 		// Set of target types
 		set<size_t>TTySet;
 
-		// Functions that are actually stored to variables
+		// Functions that are actually stored to variables; they are
+		// collected in NewStoredFuncs during the initialization
 		FuncSet StoredFuncs;
+		FuncSetBuilder NewStoredFuncs;
 
 		// Alias struct pointer of a general pointer
-		map<Function *, map<Value *, Value *>>AliasStructPtrMap;
+		ArenaMap<Function *, ArenaMap<Value *, Value *, RunArena>, RunArena>
+			AliasStructPtrMap;
 
 
 
@@ -67,34 +264,48 @@ class MLTA {
 		////////////////////////////////////////////////////////////////
 		// Type-related basic functions
 		////////////////////////////////////////////////////////////////
-		bool fuzzyTypeMatch(Type *Ty1, Type *Ty2, Module *M1, Module *M2);
-
-		void escapeType(Value *V);
-		void propagateType(Value *ToV, Type *FromTy, int Idx = -1);
+		bool fuzzyTypeMatch(Type *Ty1, Type *Ty2, ModuleInfo &MI1,
+				ModuleInfo &MI2);
 
 		Type *getBaseType(Value *V, set<Value *> &Visited);
 		Type *_getPhiBaseType(PHINode *PN, set<Value *> &Visited);
 		Function *getBaseFunction(Value *V);
-		bool nextLayerBaseType(Value *V, list<typeidx_t> &TyList, 
+		bool nextLayerBaseType(Value *V, TypeIdxList &TyList, 
 				Value * &NextV, set<Value *> &Visited);
-		bool nextLayerBaseTypeWL(Value *V, list<typeidx_t> &TyList, 
+		bool nextLayerBaseTypeWL(Value *V, TypeIdxList &TyList, 
 				Value * &NextV);
-		bool getGEPLayerTypes(GEPOperator *GEP, list<typeidx_t> &TyList);
-		bool getBaseTypeChain(list<typeidx_t> &Chain, Value *V, 
+		bool getGEPLayerTypes(GEPOperator *GEP, TypeIdxList &TyList);
+		bool getBaseTypeChain(TypeIdxList &Chain, Value *V, 
 				bool &Complete);
-		bool getDependentTypes(Type *Ty, int Idx, set<hashidx_t> &PropSet);
+		bool getDependentTypes(fieldid_t F, DenseSet<fieldid_t> &PropSet);
+
+
+		////////////////////////////////////////////////////////////////
+		// Facts found by the analysis of a module. They are applied to
+		// typeFacts here; SummaryBuilder records them in the module
+		// summary instead
+		////////////////////////////////////////////////////////////////
+		virtual void escapeType(Value *V);
+		virtual void propagateType(Value *ToV, Type *FromTy, int Idx = -1);
+		virtual void capType(Type *Ty);
+		virtual void confineTargetFunction(Value *V, Function *F);
+		// F is held by field Idx of a container in an initializer
+		virtual void confineInitializerTarget(Type *CTy, int Idx,
+				Function *F);
+		// F is passed as operand OpNo of a direct call to CF
+		virtual void confineArgTarget(Function *CF, unsigned OpNo,
+				Function *F);
 
 
 		////////////////////////////////////////////////////////////////
 		// Target-related basic functions
 		////////////////////////////////////////////////////////////////
-		void confineTargetFunction(Value *V, Function *F);
 		void intersectFuncSets(FuncSet &FS1, FuncSet &FS2,
 				FuncSet &FS); 
 		bool typeConfineInInitializer(GlobalVariable *GV);
 		bool typeConfineInFunction(Function *F);
 		bool typePropInFunction(Function *F);
-		void collectAliasStructPtr(Function *F);
+		void collectAliasStructPtr(Function *F, ModuleInfo &MI);
 
 		// deprecated 
 		//bool typeConfineInStore(StoreInst *SI);
@@ -108,8 +319,7 @@ class MLTA {
 		// Use type-based analysis to find targets of indirect calls
 		void findCalleesWithType(CallInst*, FuncSet&);
 		bool findCalleesWithMLTA(CallInst *CI, FuncSet &FS);
-		bool getTargetsWithLayerType(size_t TyHash, int Idx, 
-				FuncSet &FS);
+		bool getTargetsWithLayerType(fieldid_t F, FuncSet &FS);
 
 
 		////////////////////////////////////////////////////////////////
@@ -123,21 +333,30 @@ class MLTA {
 
 		void unrollLoops(Function *F);
 		void saveCalleesInfo(CallInst *CI, FuncSet &FS, bool mlta);
-		void printTargets(FuncSet &FS, CallInst *CI = NULL);
-		void printTypeChain(list<typeidx_t> &Chain);
+		void printTargets(const FuncSet &FS, CallInst *CI = NULL);
+		void printTypeChain(TypeIdxList &Chain);
 
 
 	public:
 
-		// General pointer types like char * and void *
-		static map<Module *, Type *>Int8PtrTy;
-		// long interger type
-		map<Module *, Type *>IntPtrTy;
-		map<Module *, const DataLayout *>DLMap;
+		vector<ModuleInfo> ModuleInfos;
+
+		// Hot paths resolve the module once and pass the ID or the
+		// ModuleInfo on, instead of looking up the Module * per query
+		ModuleInfo &getModuleInfo(unsigned ID) {
+			if (ID >= ModuleInfos.size())
+				ModuleInfos.resize(ID + 1);
+			return ModuleInfos[ID];
+		}
+
+		ModuleInfo &getModuleInfo(Module *M) {
+			return getModuleInfo(Ctx->getModuleID(M));
+		}
 
 		MLTA(GlobalContext *Ctx_) {
 			Ctx = Ctx_;
 		}
+		virtual ~MLTA() { }
 
 };
 
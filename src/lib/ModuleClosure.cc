@@ -0,0 +1,164 @@
+//===-- ModuleClosure.cc - Dependent modules of module types ----===//
+//
+// Condenses the module graph of a type into its strongly connected
+// components with Tarjan's algorithm, without recursion, as chains of
+// modules can be long in the kernel. Components are finished in
+// reverse topological order, so the dependent modules of a component
+// are computed from those of its successors right when it is found.
+//
+//===-----------------------------------------------------------===//
+
+#include "ModuleClosure.h"
+
+using namespace llvm;
+
+void ModuleClosure::clear() {
+	Edges.clear();
+	Hubs.clear();
+	Types.clear();
+	Sets.clear();
+}
+
+const ModuleClosure::SetTy &ModuleClosure::get(size_t TyH, unsigned M) {
+
+	auto Ins = Types.try_emplace(TyH);
+	TypeClosure &TC = Ins.first->second;
+	if (Ins.second) {
+		TC.Begin = std::lower_bound(Edges.data(), Edges.data() + Edges.size(),
+				TyH, [](const EdgeTy &E, size_t H) {
+					return std::get<0>(E) < H; });
+		TC.End = TC.Begin;
+		while (TC.End != Edges.data() + Edges.size()
+				&& std::get<0>(*TC.End) == TyH)
+			++TC.End;
+	}
+
+	auto It = TC.SCCOf.find(M);
+	if (It == TC.SCCOf.end()) {
+		condense(TC, M);
+		It = TC.SCCOf.find(M);
+	}
+	return *TC.SCCDeps[It->second];
+}
+
+const ModuleClosure::SetTy *ModuleClosure::getTypeSet(const TypeClosure &TC,
+		unsigned M) const {
+
+	const EdgeTy *E = std::lower_bound(TC.Begin, TC.End, M,
+			[](const EdgeTy &E, unsigned M) {
+				return std::get<1>(E) < M; });
+	if (E != TC.End && std::get<1>(*E) == M)
+		return std::get<2>(*E);
+	return NULL;
+}
+
+void ModuleClosure::pushFrame(const TypeClosure &TC, unsigned M) {
+
+	Active[M] = std::make_pair(NextIndex, NextIndex);
+	++NextIndex;
+	Stack.push_back(M);
+
+	Frame F;
+	F.M = M;
+	F.BeginSucc = F.NextSucc = Succs.size();
+	if (const SetTy *S = getTypeSet(TC, M)) {
+		for (unsigned W : *S)
+			Succs.push_back(W);
+	}
+	// Handling transitioning modules that can pass function
+	// pointers, although there is no function type
+	if (const SetTy *S = Hubs[M]) {
+		for (unsigned W : *S)
+			Succs.push_back(W);
+	}
+	F.EndSucc = Succs.size();
+	Frames.push_back(F);
+}
+
+void ModuleClosure::condense(TypeClosure &TC, unsigned Root) {
+
+	NextIndex = 0;
+	pushFrame(TC, Root);
+
+	while (!Frames.empty()) {
+		Frame &F = Frames.back();
+		if (F.NextSucc < F.EndSucc) {
+			unsigned W = Succs[F.NextSucc++];
+			// In a component found before
+			if (TC.SCCOf.count(W))
+				continue;
+			auto It = Active.find(W);
+			if (It == Active.end()) {
+				pushFrame(TC, W);
+				continue;
+			}
+			// On the stack, in the component of M or one below it
+			unsigned Index = It->second.first;
+			auto &V = Active.find(F.M)->second;
+			V.second = std::min(V.second, Index);
+			continue;
+		}
+
+		unsigned M = F.M;
+		Succs.resize(F.BeginSucc);
+		Frames.pop_back();
+
+		auto VL = Active.find(M)->second;
+		if (VL.first == VL.second)
+			finishSCC(TC, M);
+		if (!Frames.empty()) {
+			auto &P = Active.find(Frames.back().M)->second;
+			P.second = std::min(P.second, VL.second);
+		}
+	}
+}
+
+void ModuleClosure::finishSCC(TypeClosure &TC, unsigned Root) {
+
+	unsigned SCC = TC.SCCDeps.size();
+	unsigned First = Stack.size();
+	do {
+		--First;
+	} while (Stack[First] != Root);
+	for (unsigned i = First; i < Stack.size(); ++i) {
+		TC.SCCOf[Stack[i]] = SCC;
+		Active.erase(Stack[i]);
+	}
+
+	// The propagation sets of the members, and the dependent modules
+	// of the successor components, which are all finished
+	SmallVector<const SetTy *, 8> Parts;
+	auto addSucc = [&](unsigned W) {
+		unsigned C = TC.SCCOf.find(W)->second;
+		if (C != SCC && !TC.SCCDeps[C]->empty())
+			Parts.push_back(TC.SCCDeps[C]);
+	};
+	for (unsigned i = First; i < Stack.size(); ++i) {
+		unsigned M = Stack[i];
+		if (const SetTy *S = getTypeSet(TC, M)) {
+			if (!S->empty())
+				Parts.push_back(S);
+			for (unsigned W : *S)
+				addSucc(W);
+		}
+		if (const SetTy *S = Hubs[M]) {
+			for (unsigned W : *S)
+				addSucc(W);
+		}
+	}
+	Stack.resize(First);
+
+	std::sort(Parts.begin(), Parts.end());
+	Parts.erase(std::unique(Parts.begin(), Parts.end()), Parts.end());
+	if (Parts.empty())
+		TC.SCCDeps.push_back(&Empty);
+	else if (Parts.size() == 1)
+		TC.SCCDeps.push_back(Parts[0]);
+	else {
+		Sets.emplace_back();
+		SetTy &Deps = Sets.back();
+		for (const SetTy *S : Parts)
+			Deps |= *S;
+		TC.SCCDeps.push_back(&Deps);
+	}
+}
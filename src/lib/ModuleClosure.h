@@ -0,0 +1,93 @@
+#ifndef _MODULE_CLOSURE_H
+#define _MODULE_CLOSURE_H
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/SparseBitVector.h>
+#include <algorithm>
+#include <deque>
+#include <tuple>
+#include <vector>
+
+//
+// Dependent modules of (module, type) pairs for a phase of TyPM. For
+// a type, modules form a graph: the facts of the type flow into a
+// module from the modules in its propagation set, and general
+// pointers (i8*) pass them on from the modules in the propagation set
+// of the general pointer type. The dependent modules of a module are
+// the union of the propagation sets of the type over all modules it
+// reaches.
+//
+// The graph of a type is condensed into its strongly connected
+// components when the type is first asked for, and the dependent
+// modules are computed once per component, in topological order.
+// Components without modules of their own share the set of their
+// only successor.
+//
+class ModuleClosure {
+
+	public:
+		typedef llvm::SparseBitVector<> SetTy;
+
+		// Set up the graphs of a phase. PropMap maps (module ID, type
+		// hash) to a propagation set, and HubTypes gives the hash of
+		// the general pointer type of each module. The sets of PropMap
+		// are referred to, so it must not change until clear().
+		template <typename MapTy>
+		void build(const MapTy &PropMap, const std::vector<size_t> &HubTypes) {
+			clear();
+			for (auto &P : PropMap)
+				Edges.push_back(std::make_tuple(P.first.second,
+							P.first.first, &P.second));
+			std::sort(Edges.begin(), Edges.end());
+			Hubs.assign(HubTypes.size(), NULL);
+			for (unsigned M = 0; M < HubTypes.size(); ++M) {
+				auto It = PropMap.find(std::make_pair(M, HubTypes[M]));
+				if (It != PropMap.end())
+					Hubs[M] = &It->second;
+			}
+		}
+		void clear();
+
+		// The dependent modules of M for the type of hash TyH
+		const SetTy &get(size_t TyH, unsigned M);
+
+	private:
+		// (type hash, module ID, propagation set), sorted
+		typedef std::tuple<size_t, unsigned, const SetTy *> EdgeTy;
+		std::vector<EdgeTy> Edges;
+		// Propagation set of the general pointer type of each module
+		std::vector<const SetTy *> Hubs;
+
+		struct TypeClosure {
+			// The propagation sets of the type, in Edges
+			const EdgeTy *Begin, *End;
+			// Component of each module reached so far
+			llvm::DenseMap<unsigned, unsigned> SCCOf;
+			// Dependent modules of each component
+			std::vector<const SetTy *> SCCDeps;
+		};
+		llvm::DenseMap<size_t, TypeClosure> Types;
+		std::deque<SetTy> Sets;
+		SetTy Empty;
+
+		// Scratch state of the SCC search, see condense()
+		struct Frame {
+			unsigned M;
+			// Successors of M still to visit, in Succs
+			unsigned BeginSucc, NextSucc, EndSucc;
+		};
+		llvm::SmallVector<Frame, 16> Frames;
+		llvm::SmallVector<unsigned, 64> Succs;
+		llvm::SmallVector<unsigned, 16> Stack;
+		// Visit index and low link of the modules on Stack
+		llvm::DenseMap<unsigned, std::pair<unsigned, unsigned>> Active;
+		unsigned NextIndex;
+
+		const SetTy *getTypeSet(const TypeClosure &TC, unsigned M) const;
+		void pushFrame(const TypeClosure &TC, unsigned M);
+		void condense(TypeClosure &TC, unsigned Root);
+		void finishSCC(TypeClosure &TC, unsigned Root);
+};
+
+#endif
@@ -0,0 +1,849 @@
+//===-- Summary.cc - Summarize modules for the call graph -------===//
+//
+// This file extracts compact summaries from modules. A summary
+// records the module-local results of the initialization and of the
+// later phases of the call-graph pass, so that the cross-module
+// analysis can run without the IR.
+//
+//===-----------------------------------------------------------===//
+
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/IR/DebugInfo.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/xxhash.h"
+
+#include "Common.h"
+#include "Summary.h"
+
+
+using namespace llvm;
+
+//
+// Implementation
+//
+
+TypeRef SummaryBuilder::getTypeRef(Type *Ty) {
+
+	auto It = TypeRefs.find(Ty);
+	if (It != TypeRefs.end())
+		return It->second;
+
+	TypeRef R = Sum->Types.size();
+	TypeRefs[Ty] = R;
+	Sum->Types.push_back(TypeSummary());
+
+	TypeSummary TS;
+	if (StructType *STy = dyn_cast<StructType>(Ty)) {
+		TS.Kind = STK_Struct;
+		if (STy->hasName()) {
+			TS.Name = STy->getName().str();
+			TS.Hash = typeHash(STy);
+		}
+		else {
+			// Resolved against the struct names of all modules
+			TS.Literal = true;
+			TS.LiteralShape = structShapeHash(STy);
+		}
+	}
+	else {
+		TS.Hash = typeHash(Ty);
+		if (PointerType *PTy = dyn_cast<PointerType>(Ty)) {
+			TS.Kind = STK_Pointer;
+			TS.Pointee = getTypeRef(PTy->getPointerElementType());
+		}
+		else if (Ty->isIntegerTy()) {
+			TS.Kind = STK_Integer;
+			TS.Width = Ty->getIntegerBitWidth();
+		}
+		else if (Ty->isArrayTy())
+			TS.Kind = STK_Array;
+		else if (Ty->isVectorTy())
+			TS.Kind = STK_Vector;
+		else if (Ty->isFunctionTy())
+			TS.Kind = STK_Function;
+	}
+	Sum->Types[R] = TS;
+
+	return R;
+}
+
+// Types that may be printed by the analysis keep their text, as does
+// their base type without pointers
+TypeRef SummaryBuilder::getPrintedTypeRef(Type *Ty) {
+
+	TypeRef R = getTypeRef(Ty);
+	Type *BTy = Ty;
+	while (true) {
+		TypeRef BR = getTypeRef(BTy);
+		if (Sum->Types[BR].Text.empty()) {
+			raw_string_ostream OS(Sum->Types[BR].Text);
+			BTy->print(OS);
+		}
+		if (!BTy->isPointerTy())
+			break;
+		BTy = BTy->getPointerElementType();
+	}
+
+	return R;
+}
+
+FuncRef SummaryBuilder::getFuncRef(Function *F) {
+
+	auto It = FuncRefs.find(F);
+	if (It != FuncRefs.end())
+		return It->second;
+
+	FuncRef R = Sum->Funcs.size();
+	FuncRefs[F] = R;
+
+	FuncSummary FS;
+	FS.Name = F->getName().str();
+	FS.GUID = F->getGUID();
+	FS.Hash = funcHash(F, false);
+	FS.IsDeclaration = F->isDeclaration();
+	FS.IsIntrinsic = F->isIntrinsic();
+	FS.HasExternalLinkage = F->hasExternalLinkage();
+	FS.HasAddressTaken = F->hasAddressTaken();
+	FS.IsVarArg = F->getFunctionType()->isVarArg();
+	FS.DoesNotAccessMemory = F->doesNotAccessMemory();
+	FS.OnlyReadsMemory = F->onlyReadsMemory();
+	FS.OnlyWritesMemory = F->onlyWritesMemory();
+	FS.RetTy = getTypeRef(F->getReturnType());
+
+	for (Argument &A : F->args()) {
+		ArgSummary AS;
+		Type *ATy = A.getType();
+		AS.Ty = getTypeRef(ATy);
+		AS.IsTarget = isTargetTy(ATy);
+		if (!AS.IsTarget) {
+			if (PointerType *PTy = dyn_cast<PointerType>(ATy)) {
+				Type *ETy = PTy->getPointerElementType();
+				if (isTargetTy(ETy))
+					AS.TargetElemTy = getTypeRef(ETy);
+			}
+		}
+		FS.Args.push_back(AS);
+	}
+
+	if (DISubprogram *SP = F->getSubprogram()) {
+		FS.Src.Valid = true;
+		FS.Src.File = SP->getFilename().str();
+		FS.Src.Line = SP->getLine();
+	}
+
+	Sum->Funcs.push_back(FS);
+
+	return R;
+}
+
+void SummaryBuilder::getChainSummary(TypeIdxList &Chain,
+		bool Complete, TypeChainSummary &CS) {
+
+	for (auto TI : Chain)
+		CS.Types.push_back(make_pair(getTypeRef(TI.first), TI.second));
+	CS.Complete = Complete;
+}
+
+void SummaryBuilder::getChainSummary(Value *V, TypeChainSummary &CS) {
+
+	TypeIdxList Chain;
+	bool Complete = true;
+	getBaseTypeChain(Chain, V, Complete);
+	getChainSummary(Chain, Complete, CS);
+}
+
+void SummaryBuilder::getSourceSummary(Instruction *I,
+		SourceSummary &SS) {
+
+	DILocation *Loc = getSourceLocation(I);
+	if (!Loc)
+		return;
+
+	SS.Valid = true;
+	SS.File = Loc->getFilename().str();
+	SS.Line = Loc->getLine();
+}
+
+//
+// Facts of MLTA and TyPM, recorded for the function or the global
+// being analyzed
+//
+
+void SummaryBuilder::escapeType(Value *V) {
+
+	TypeChainSummary ES;
+	getChainSummary(V, ES);
+	if (!ES.Types.empty())
+		Sum->Funcs[CurFunc].Escapes.push_back(ES);
+}
+
+void SummaryBuilder::propagateType(Value *ToV, Type *FromTy, int Idx) {
+
+	PropSummary PS;
+	getChainSummary(ToV, PS.Chain);
+	if (PS.Chain.Types.empty())
+		return;
+	PS.FromTypes.push_back(make_pair(getTypeRef(FromTy), Idx));
+	Sum->Funcs[CurFunc].Props.push_back(PS);
+}
+
+void SummaryBuilder::capType(Type *Ty) {
+	CurGlobal->InitCaps.push_back(getTypeRef(Ty));
+}
+
+void SummaryBuilder::confineTargetFunction(Value *V, Function *F) {
+
+	if (F->isIntrinsic())
+		return;
+
+	ConfineSummary CS;
+	CS.Func = getFuncRef(F);
+	getChainSummary(V, CS.Chain);
+	Sum->Funcs[CurFunc].Confines.push_back(CS);
+}
+
+void SummaryBuilder::confineInitializerTarget(Type *CTy, int Idx,
+		Function *F) {
+
+	InitConfineSummary IC;
+	IC.Func = getFuncRef(F);
+	IC.Container = getTypeRef(CTy);
+	IC.Idx = Idx;
+	CurGlobal->InitConfines.push_back(IC);
+}
+
+// The actual function of a declaration is only known when all
+// summaries are available
+void SummaryBuilder::confineArgTarget(Function *CF, unsigned OpNo,
+		Function *F) {
+
+	if (!CF->isDeclaration()) {
+		MLTA::confineArgTarget(CF, OpNo, F);
+		return;
+	}
+
+	ArgConfineSummary AC;
+	AC.Func = getFuncRef(F);
+	AC.Callee = getFuncRef(CF);
+	AC.OperandNo = OpNo;
+	Sum->Funcs[CurFunc].ArgConfines.push_back(AC);
+}
+
+// Repeated uses of a global are recorded once
+void SummaryBuilder::addGlobalUse(unsigned Kind, Type *Ty) {
+
+	TypeRef R = Ty ? getTypeRef(Ty) : -1;
+	if (GlobalUses.insert(make_pair(Kind, R)).second)
+		CurGlobal->Uses.push_back(GlobalUseSummary{Kind, R});
+}
+
+void SummaryBuilder::addModuleToGVType(Type *Ty, Module *M,
+		GlobalVariable *GV) {
+	addGlobalUse(GUK_FromModule, Ty);
+}
+
+void SummaryBuilder::addGVToModuleType(Type *Ty, GlobalVariable *GV,
+		Module *M) {
+	addGlobalUse(GUK_ToModule, Ty);
+}
+
+// The initializer may be in another module
+void SummaryBuilder::addGVInitializerToModule(GlobalVariable *GV,
+		Module *M) {
+	addGlobalUse(GUK_Call, NULL);
+}
+
+void SummaryBuilder::addTargetAlloc(Type *Ty, Module *M) {
+	Sum->AllocTypes.push_back(getTypeRef(Ty));
+}
+
+// External globals of the initializer are resolved across modules,
+// and the walk may be for another module, see GlobalSummary::InitStored
+void SummaryBuilder::summarizeInitializer(GlobalVariable *GV,
+		GlobalSummary &GS) {
+
+	set<Type *> TargetTypes, AllocTypes;
+	set<typeidx_t> StoredTypeIdx;
+	vector<GlobalVariable *> Externals;
+	parseInitializer(GV, TargetTypes, AllocTypes, StoredTypeIdx, Externals);
+
+	for (auto Ty : TargetTypes)
+		GS.InitTypes.push_back(getTypeRef(Ty));
+	for (auto Ty : AllocTypes)
+		GS.InitAllocTypes.push_back(getTypeRef(Ty));
+	for (auto GO : Externals)
+		GS.InitExternals.push_back(GO->getGUID());
+	for (auto TI : StoredTypeIdx)
+		GS.InitStored.push_back(make_pair(getTypeRef(TI.first), TI.second));
+}
+
+// Facts of the args of a function as a callee, see
+// TyPM::parseTargetTypesInCalls() and MLTA::typeConfineInFunction()
+void SummaryBuilder::summarizeArgs(Function *F, FuncRef R) {
+
+	unsigned ArgNo = 0;
+	for (Argument &A : F->args()) {
+
+		ArgSummary AS = Sum->Funcs[R].Args[ArgNo];
+		summarizeValueFlow(&A, AS.Flow);
+
+		// Only functions with external linkage can be the actual
+		// function of a declaration
+		if (F->hasExternalLinkage()) {
+			for (auto U : A.users()) {
+				if (isa<StoreInst>(U) || isa<BitCastOperator>(U)) {
+					TypeChainSummary CS;
+					getChainSummary(U, CS);
+					AS.Confines.push_back(CS);
+				}
+			}
+		}
+		Sum->Funcs[R].Args[ArgNo++] = AS;
+	}
+}
+
+void SummaryBuilder::summarizeCalls(Function *F, FuncRef R) {
+
+	for (inst_iterator i = inst_begin(F), e = inst_end(F);
+			i != e; ++i) {
+
+		CallInst *CI = dyn_cast<CallInst>(&*i);
+		if (!CI)
+			continue;
+
+		// Direct calls only matter to TyPM when they pass arguments
+		Function *CF = dyn_cast<Function>(CI->getCalledOperand());
+		bool IsICall = CI->isIndirectCall();
+		if (!IsICall && (!CF || CF->isIntrinsic() || CI->arg_empty()))
+			continue;
+
+		CallSummary CS;
+		if (IsICall) {
+			ICallSummary IS;
+			summarizeICall(CI, IS);
+			CS.ICall = Sum->Funcs[R].ICalls.size();
+			Sum->Funcs[R].ICalls.push_back(IS);
+		}
+		else
+			CS.Callee = getFuncRef(CF);
+
+		if (!CI->arg_empty()) {
+			for (unsigned OI = 0; OI < CI->getNumOperands(); ++OI) {
+				if (Function *AF = dyn_cast<Function>(CI->getOperand(OI)))
+					CS.ArgFuncs.push_back(make_pair(OI, getFuncRef(AF)));
+			}
+			CS.RetTy = getTypeRef(CI->getType());
+			summarizeValueFlow(CI, CS.RetFlow);
+		}
+		Sum->Funcs[R].Calls.push_back(CS);
+	}
+}
+
+void SummaryBuilder::summarizeICall(CallInst *CI, ICallSummary &IS) {
+
+	CallBase *CB = dyn_cast<CallBase>(CI);
+	IS.Hash = callHash(CI);
+	IS.FuncTy = getTypeRef(CB->getFunctionType());
+	IS.RetTy = getTypeRef(CI->getType());
+	for (auto &A : CB->args())
+		IS.ArgTys.push_back(getTypeRef(A->getType()));
+
+	Value *CV = CI->getCalledOperand();
+	IS.CalledTy = getPrintedTypeRef(CV->getType());
+
+	// Layer types, see MLTA::findCalleesWithMLTA()
+	Value *LV = CV;
+	while (IS.Layers.size() < MAX_TYPE_LAYER) {
+		TypeIdxList TyList;
+		Value *NextV = NULL;
+		set<Value *> Visited;
+		nextLayerBaseType(LV, TyList, NextV, Visited);
+		if (TyList.empty())
+			break;
+
+		vector<typerefidx_t> Layer;
+		for (auto TyIdx : TyList)
+			Layer.push_back(make_pair(getTypeRef(TyIdx.first), TyIdx.second));
+		IS.Layers.push_back(Layer);
+		LV = NextV;
+	}
+
+	// The outermost layer type, see TyPM::getDependentModulesV()
+	TypeIdxList TyList;
+	Value *TV = CV, *NextV = NULL;
+	set<Value*> Visited;
+	while (nextLayerBaseTypeWL(TV, TyList, NextV)) {
+		Visited.insert(TV);
+		if (Visited.find(NextV) != Visited.end()) {
+			break;
+		}
+		TV = NextV;
+	}
+	if (!TyList.empty()) {
+		IS.OuterTy = getPrintedTypeRef(TyList.front().first);
+		IS.OuterIdx = TyList.front().second;
+	}
+
+	raw_string_ostream OS(IS.Text);
+	OS << *CI;
+	OS.flush();
+	getSourceSummary(CI, IS.Src);
+	if (Instruction *I = dyn_cast<Instruction>(CV)) {
+		getSourceSummary(I, IS.CalledSrc);
+		if (IS.CalledSrc.Valid) {
+			raw_string_ostream COS(IS.CalledText);
+			COS << *I;
+		}
+	}
+}
+
+void SummaryBuilder::summarizeValueFlow(Value *V, ValueFlowSummary &VS) {
+
+	set<Type *> ReadTypes, WrittenTypes;
+	VS.Parsable = parseUsesOfValue(V, ReadTypes, WrittenTypes, CurM);
+
+	if (VS.Parsable) {
+		for (auto Ty : ReadTypes)
+			VS.ReadTypes.push_back(getTypeRef(Ty));
+		for (auto Ty : WrittenTypes)
+			VS.WrittenTypes.push_back(getTypeRef(Ty));
+	}
+	else {
+		const TypeList &TySet = findTargetTypesInValue(V, CurM);
+		for (auto Ty : TySet)
+			VS.TargetTypes.push_back(getTypeRef(Ty));
+	}
+}
+
+// Drop all module-local state, as the module is freed afterwards
+void SummaryBuilder::reset() {
+
+	AliasStructPtrMap.clear();
+	ParsedTypeMap.clear();
+	ParsedGlobalTypesMap.clear();
+	TypeLists.clear();
+	NumStores = 0;
+	StoredFuncs.clear();
+	NewStoredFuncs.clear();
+	VTableFuncsMap.clear();
+	typeFacts.clear();
+
+	ModuleInfos.clear();
+	Ctx->ModuleIDs.erase(CurM);
+	// All containers on the arenas are cleared above
+	RunArena::reset();
+	FunctionArena::reset();
+
+	TypeRefs.clear();
+	FuncRefs.clear();
+	GlobalUses.clear();
+	clearTypeHashCache();
+	CurM = NULL;
+	Sum = NULL;
+	CurFunc = -1;
+	CurGlobal = NULL;
+}
+
+void SummaryBuilder::summarize(Module *M, ModuleSummary &S) {
+
+	CurM = M;
+	Sum = &S;
+
+	S.Name = M->getName().str();
+
+	// The module is the only one the builder sees
+	Ctx->ModuleIDs[M] = 0;
+	ModuleInfo &MI = getModuleInfo(M);
+	MI.DL = &(M->getDataLayout());
+	MI.Int8PtrTy = Type::getInt8PtrTy(M->getContext());
+	MI.IntPtrTy = MI.DL->getIntPtrType(M->getContext());
+	S.Int8PtrTy = getTypeRef(MI.Int8PtrTy);
+	S.IntPtrTy = getTypeRef(MI.IntPtrTy);
+
+	for (auto STy : M->getIdentifiedStructTypes()) {
+		if (!STy->hasName() || STy->isOpaque())
+			continue;
+		S.StructNames.push_back(make_pair(structShapeHash(STy),
+					STy->getName().str()));
+	}
+
+	materializeModule(M);
+
+	// Functions with body and address-taken functions, in order
+	for (Function &F : *M) {
+		if (F.isIntrinsic())
+			continue;
+		if (!F.isDeclaration() || F.hasAddressTaken())
+			getFuncRef(&F);
+	}
+
+	//
+	// The module-local part of CallGraphPass::doInitialization(), in
+	// the same order, as later steps depend on earlier ones
+	//
+	set<User *>CastSet;
+	for (GlobalVariable &GV : M->globals()) {
+
+		S.Globals.push_back(GlobalSummary());
+		GlobalSummary &GS = S.Globals.back();
+		GS.GUID = GV.getGUID();
+		GS.HasInitializer = GV.hasInitializer();
+		if (GV.hasInitializer()) {
+			Type *ITy = GV.getInitializer()->getType();
+			if (ITy->isPointerTy() || isContainerTy(ITy)) {
+				GS.IsInitCandidate = true;
+				CurGlobal = &GS;
+				typeConfineInInitializer(&GV);
+				findCastsInGV(&GV, CastSet);
+			}
+		}
+	}
+
+	for (Function &F : *M) {
+
+		if (F.isIntrinsic() || F.isDeclaration())
+			continue;
+
+		CurFunc = getFuncRef(&F);
+		typePropInFunction(&F);
+		collectAliasStructPtr(&F, MI);
+		typeConfineInFunction(&F);
+		findCastsInFunction(&F, CastSet);
+		findStoredTypeIdxInFunction(&F);
+		findTargetAllocInFunction(&F);
+	}
+	processCasts(CastSet, M);
+
+	//
+	// Facts of the later phases, on the fully initialized module
+	//
+	unsigned GIdx = 0;
+	for (GlobalVariable &GV : M->globals()) {
+		GlobalSummary &GS = S.Globals[GIdx++];
+		if (GV.hasInitializer())
+			summarizeInitializer(&GV, GS);
+		CurGlobal = &GS;
+		GlobalUses.clear();
+		set<Value *>Visited;
+		parseUsesOfGV(&GV, &GV, M, Visited);
+	}
+
+	for (Function &F : *M) {
+
+		if (F.isIntrinsic() || F.isDeclaration())
+			continue;
+
+		FuncRef R = getFuncRef(&F);
+		summarizeArgs(&F, R);
+		summarizeCalls(&F, R);
+	}
+
+	for (auto &TI : getModuleInfo(M).StoredTypeIdx) {
+		TypeRef T = getTypeRef(TI.first);
+		for (auto Idx : TI.second)
+			S.StoredTypeIdx.push_back(make_pair(T, Idx));
+	}
+
+	reset();
+}
+
+uint64_t SummaryBuilder::getConfigHash() {
+
+	string Config = SUMMARY_MAGIC;
+	Config += " version=" + to_string(SUMMARY_VERSION);
+#ifdef SOUND_MODE
+	Config += " SOUND_MODE";
+#endif
+#ifdef PARSE_VALUE_USES
+	Config += " PARSE_VALUE_USES";
+#endif
+#ifdef TYPE_ELEVATION
+	Config += " TYPE_ELEVATION";
+#endif
+#ifdef FLOW_DIRECTION
+	Config += " FLOW_DIRECTION";
+#endif
+#ifdef MLTA_FIELD_INSENSITIVE
+	Config += " MLTA_FIELD_INSENSITIVE";
+#endif
+#ifdef FUNCTION_AS_TARGET_TYPE
+	Config += " FUNCTION_AS_TARGET_TYPE=" +
+		to_string(FUNCTION_AS_TARGET_TYPE);
+#endif
+	Config += " MAX_TYPE_LAYER=" + to_string(MAX_TYPE_LAYER);
+	Config += " target-types=";
+	for (size_t TyH : TTySet)
+		Config += to_string(TyH) + ",";
+
+	return xxHash64(Config);
+}
+
+//
+// Summary files
+//
+
+// Fields are visited in file order, by both the writer and the reader
+template <typename A, typename T>
+typename std::enable_if<std::is_integral<T>::value>::type
+visitSummary(A &Ar, T &V) {
+	Ar(V);
+}
+
+template <typename A>
+void visitSummary(A &Ar, string &V) {
+	Ar(V);
+}
+
+template <typename A, typename T1, typename T2>
+void visitSummary(A &Ar, pair<T1, T2> &V) {
+	Ar(V);
+}
+
+template <typename A, typename T>
+void visitSummary(A &Ar, vector<T> &V) {
+	Ar(V);
+}
+
+// Integers are written as 8 bytes, little endian; strings and vectors
+// are prefixed by their size
+class SummaryWriter {
+
+	public:
+		string Buf;
+
+		template <typename T>
+		typename std::enable_if<std::is_integral<T>::value>::type
+		operator()(T &V) {
+			uint64_t X = (uint64_t)V;
+			for (int i = 0; i < 8; ++i)
+				Buf.push_back((char)((X >> (8 * i)) & 0xff));
+		}
+		void operator()(string &V) {
+			size_t Size = V.size();
+			(*this)(Size);
+			Buf.append(V);
+		}
+		template <typename T1, typename T2>
+		void operator()(pair<T1, T2> &V) {
+			(*this)(V.first);
+			(*this)(V.second);
+		}
+		template <typename T>
+		void operator()(vector<T> &V) {
+			size_t Size = V.size();
+			(*this)(Size);
+			for (auto &E : V)
+				visitSummary(*this, E);
+		}
+};
+
+class SummaryReader {
+
+	public:
+		const char *Cur;
+		const char *End;
+		bool Failed = false;
+
+		SummaryReader(const char *Begin, const char *End_)
+			: Cur(Begin), End(End_) { }
+
+		template <typename T>
+		typename std::enable_if<std::is_integral<T>::value>::type
+		operator()(T &V) {
+			if (End - Cur < 8) {
+				Failed = true;
+				Cur = End;
+				V = 0;
+				return;
+			}
+			uint64_t X = 0;
+			for (int i = 0; i < 8; ++i)
+				X |= (uint64_t)(unsigned char)Cur[i] << (8 * i);
+			Cur += 8;
+			V = (T)X;
+		}
+		void operator()(string &V) {
+			size_t Size;
+			(*this)(Size);
+			if (Size > (size_t)(End - Cur)) {
+				Failed = true;
+				Cur = End;
+				return;
+			}
+			V.assign(Cur, Size);
+			Cur += Size;
+		}
+		template <typename T1, typename T2>
+		void operator()(pair<T1, T2> &V) {
+			(*this)(V.first);
+			(*this)(V.second);
+		}
+		template <typename T>
+		void operator()(vector<T> &V) {
+			size_t Size;
+			(*this)(Size);
+			// Every element takes at least one byte
+			if (Size > (size_t)(End - Cur)) {
+				Failed = true;
+				Cur = End;
+				return;
+			}
+			V.resize(Size);
+			for (auto &E : V)
+				visitSummary(*this, E);
+		}
+};
+
+template <typename A>
+void visitSummary(A &Ar, TypeSummary &T) {
+	Ar(T.Kind); Ar(T.Hash); Ar(T.Name); Ar(T.LiteralShape);
+	Ar(T.Literal); Ar(T.Width); Ar(T.Pointee); Ar(T.Text);
+}
+
+template <typename A>
+void visitSummary(A &Ar, TypeChainSummary &C) {
+	Ar(C.Types); Ar(C.Complete);
+}
+
+template <typename A>
+void visitSummary(A &Ar, ValueFlowSummary &VS) {
+	Ar(VS.Parsable); Ar(VS.ReadTypes); Ar(VS.WrittenTypes);
+	Ar(VS.TargetTypes);
+}
+
+template <typename A>
+void visitSummary(A &Ar, SourceSummary &SS) {
+	Ar(SS.Valid); Ar(SS.File); Ar(SS.Line);
+}
+
+template <typename A>
+void visitSummary(A &Ar, ArgSummary &AS) {
+	Ar(AS.Ty); Ar(AS.IsTarget); Ar(AS.TargetElemTy);
+	visitSummary(Ar, AS.Flow);
+	Ar(AS.Confines);
+}
+
+template <typename A>
+void visitSummary(A &Ar, ConfineSummary &CS) {
+	Ar(CS.Func);
+	visitSummary(Ar, CS.Chain);
+}
+
+template <typename A>
+void visitSummary(A &Ar, ArgConfineSummary &AC) {
+	Ar(AC.Func); Ar(AC.Callee); Ar(AC.OperandNo);
+}
+
+template <typename A>
+void visitSummary(A &Ar, PropSummary &PS) {
+	visitSummary(Ar, PS.Chain);
+	Ar(PS.FromTypes);
+}
+
+template <typename A>
+void visitSummary(A &Ar, CallSummary &CS) {
+	Ar(CS.Callee); Ar(CS.ICall); Ar(CS.ArgFuncs); Ar(CS.RetTy);
+	visitSummary(Ar, CS.RetFlow);
+}
+
+template <typename A>
+void visitSummary(A &Ar, ICallSummary &IS) {
+	Ar(IS.Hash); Ar(IS.FuncTy); Ar(IS.RetTy); Ar(IS.ArgTys);
+	Ar(IS.CalledTy); Ar(IS.Layers); Ar(IS.OuterTy); Ar(IS.OuterIdx);
+	Ar(IS.Text);
+	visitSummary(Ar, IS.Src);
+	Ar(IS.CalledText);
+	visitSummary(Ar, IS.CalledSrc);
+}
+
+template <typename A>
+void visitSummary(A &Ar, FuncSummary &F) {
+	Ar(F.Name); Ar(F.GUID); Ar(F.Hash); Ar(F.IsDeclaration);
+	Ar(F.IsIntrinsic); Ar(F.HasExternalLinkage); Ar(F.HasAddressTaken);
+	Ar(F.IsVarArg); Ar(F.DoesNotAccessMemory); Ar(F.OnlyReadsMemory);
+	Ar(F.OnlyWritesMemory); Ar(F.RetTy); Ar(F.Args);
+	visitSummary(Ar, F.Src);
+	Ar(F.Props); Ar(F.Escapes); Ar(F.Confines); Ar(F.ArgConfines);
+	Ar(F.Calls); Ar(F.ICalls);
+}
+
+template <typename A>
+void visitSummary(A &Ar, InitConfineSummary &IC) {
+	Ar(IC.Func); Ar(IC.Container); Ar(IC.Idx);
+}
+
+template <typename A>
+void visitSummary(A &Ar, GlobalUseSummary &GU) {
+	Ar(GU.Kind); Ar(GU.Ty);
+}
+
+template <typename A>
+void visitSummary(A &Ar, GlobalSummary &GS) {
+	Ar(GS.GUID); Ar(GS.HasInitializer); Ar(GS.IsInitCandidate);
+	Ar(GS.InitTypes); Ar(GS.InitAllocTypes); Ar(GS.InitExternals);
+	Ar(GS.InitStored); Ar(GS.InitConfines); Ar(GS.InitCaps);
+	Ar(GS.Uses);
+}
+
+template <typename A>
+void visitSummary(A &Ar, ModuleSummary &S) {
+	Ar(S.Name); Ar(S.Types); Ar(S.StructNames); Ar(S.Int8PtrTy);
+	Ar(S.IntPtrTy); Ar(S.Funcs); Ar(S.Globals); Ar(S.StoredTypeIdx);
+	Ar(S.AllocTypes);
+}
+
+bool writeModuleSummary(ModuleSummary &S, string Path) {
+
+	SummaryWriter W;
+	W.Buf.append(SUMMARY_MAGIC, sizeof(SUMMARY_MAGIC));
+	unsigned Version = SUMMARY_VERSION;
+	W(Version);
+	visitSummary(W, S);
+
+	std::error_code EC;
+	raw_fd_ostream OS(Path, EC, sys::fs::OF_None);
+	if (EC)
+		return false;
+	OS << W.Buf;
+	OS.close();
+	return !OS.has_error();
+}
+
+bool readModuleSummary(string Path, ModuleSummary &S, string &Err) {
+
+	ErrorOr<std::unique_ptr<MemoryBuffer>> MBOrErr =
+		MemoryBuffer::getFile(Path);
+	if (!MBOrErr) {
+		Err = MBOrErr.getError().message();
+		return false;
+	}
+
+	StringRef Buf = (*MBOrErr)->getBuffer();
+	if (!Buf.startswith(StringRef(SUMMARY_MAGIC, sizeof(SUMMARY_MAGIC)))) {
+		Err = "not a summary file";
+		return false;
+	}
+
+	SummaryReader R(Buf.data() + sizeof(SUMMARY_MAGIC),
+			Buf.data() + Buf.size());
+	unsigned Version;
+	R(Version);
+	if (R.Failed || Version != SUMMARY_VERSION) {
+		Err = "unsupported summary version";
+		return false;
+	}
+
+	visitSummary(R, S);
+	if (R.Failed || R.Cur != R.End) {
+		Err = "malformed summary file";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,302 @@
+#ifndef _MODULE_SUMMARY_H
+#define _MODULE_SUMMARY_H
+
+#include "Analyzer.h"
+#include "MLTA.h"
+#include "TyPM.h"
+#include "Config.h"
+
+//
+// Module summaries: compact, IR-free records of everything the
+// call-graph phases need from a module. Types, functions and globals
+// are referred to by their index in the summary; references across
+// modules stay symbolic (GUIDs and struct shapes) and are resolved
+// only when all summaries are available, so the module and its
+// LLVMContext can be freed right after it is summarized.
+//
+
+// Index into ModuleSummary::Types, or -1
+typedef int TypeRef;
+// Index into ModuleSummary::Funcs, or -1
+typedef int FuncRef;
+typedef pair<TypeRef, int> typerefidx_t;
+
+enum SummaryTypeKind {
+	STK_Other = 0,
+	STK_Pointer,
+	STK_Struct,
+	STK_Integer,
+	STK_Array,
+	STK_Vector,
+	STK_Function,
+};
+
+struct TypeSummary {
+	unsigned Kind = STK_Other;
+	// typeHash() of the type. The hash of an unnamed struct depends
+	// on the struct names of all modules, see LiteralShape
+	size_t Hash = 0;
+	// Name of a struct type; empty for an unnamed struct
+	string Name;
+	// structShapeHash() of an unnamed struct, 0 otherwise
+	uint64_t LiteralShape = 0;
+	bool Literal = false;
+	// Width of an integer type
+	unsigned Width = 0;
+	// Element type of a pointer type
+	TypeRef Pointee = -1;
+	// The printed type, only kept for types that are printed
+	string Text;
+};
+
+// A chain of base types, see MLTA::getBaseTypeChain()
+struct TypeChainSummary {
+	vector<typerefidx_t> Types;
+	bool Complete = true;
+};
+
+// Types read and written through a value, see
+// TyPM::parseUsesOfValue(); if its uses are not parsable, all target
+// types the value may carry, see TyPM::findTargetTypesInValue()
+struct ValueFlowSummary {
+	bool Parsable = false;
+	vector<TypeRef> ReadTypes;
+	vector<TypeRef> WrittenTypes;
+	vector<TypeRef> TargetTypes;
+};
+
+// Debug location of an instruction or a function
+struct SourceSummary {
+	bool Valid = false;
+	string File;
+	unsigned Line = 0;
+};
+
+struct ArgSummary {
+	TypeRef Ty = -1;
+	// isTargetTy() of the type
+	bool IsTarget = false;
+	// The element type, if the arg points to a target type
+	TypeRef TargetElemTy = -1;
+	ValueFlowSummary Flow;
+	// Stores and casts of the arg, which confine functions passed to
+	// it; only for functions with external linkage
+	vector<TypeChainSummary> Confines;
+};
+
+// A function confined to the types of a chain
+struct ConfineSummary {
+	FuncRef Func;
+	TypeChainSummary Chain;
+};
+
+// A function passed to a function declared in the module; it is
+// confined by the stores and casts of the corresponding arg of the
+// actual function
+struct ArgConfineSummary {
+	FuncRef Func;
+	FuncRef Callee;
+	unsigned OperandNo;
+};
+
+// Types propagated to the types of a chain, see MLTA::propagateType()
+struct PropSummary {
+	TypeChainSummary Chain;
+	vector<typerefidx_t> FromTypes;
+};
+
+struct CallSummary {
+	// The called function of a direct call
+	FuncRef Callee = -1;
+	// Index into FuncSummary::ICalls of an indirect call
+	int ICall = -1;
+	// Operands that are functions
+	vector<pair<unsigned, FuncRef>> ArgFuncs;
+	TypeRef RetTy = -1;
+	ValueFlowSummary RetFlow;
+};
+
+struct ICallSummary {
+	size_t Hash = 0;
+	TypeRef FuncTy = -1;
+	TypeRef RetTy = -1;
+	vector<TypeRef> ArgTys;
+	// Type of the called value
+	TypeRef CalledTy = -1;
+	// Layers of base types of the called value, as walked by
+	// MLTA::findCalleesWithMLTA()
+	vector<vector<typerefidx_t>> Layers;
+	// The outermost layer type of the called value, see
+	// TyPM::getDependentModulesV()
+	TypeRef OuterTy = -1;
+	int OuterIdx = -1;
+	// Printing
+	string Text;
+	SourceSummary Src;
+	string CalledText;
+	SourceSummary CalledSrc;
+};
+
+struct FuncSummary {
+	string Name;
+	uint64_t GUID = 0;
+	// funcHash() of the function
+	size_t Hash = 0;
+	bool IsDeclaration = false;
+	bool IsIntrinsic = false;
+	bool HasExternalLinkage = false;
+	bool HasAddressTaken = false;
+	bool IsVarArg = false;
+	bool DoesNotAccessMemory = false;
+	bool OnlyReadsMemory = false;
+	bool OnlyWritesMemory = false;
+	TypeRef RetTy = -1;
+	vector<ArgSummary> Args;
+	SourceSummary Src;
+
+	// The following are only for functions with body
+	vector<PropSummary> Props;
+	vector<TypeChainSummary> Escapes;
+	vector<ConfineSummary> Confines;
+	vector<ArgConfineSummary> ArgConfines;
+	// Calls that matter to the later phases, in order
+	vector<CallSummary> Calls;
+	vector<ICallSummary> ICalls;
+};
+
+// A function confined to a field of a container in an initializer
+struct InitConfineSummary {
+	FuncRef Func;
+	TypeRef Container;
+	int Idx;
+};
+
+enum GlobalUseKind {
+	// A type flows from the module to the global
+	GUK_FromModule = 0,
+	// A type flows from the global to the module
+	GUK_ToModule,
+	// The global is passed to a call
+	GUK_Call,
+};
+
+struct GlobalUseSummary {
+	unsigned Kind;
+	TypeRef Ty;
+};
+
+struct GlobalSummary {
+	uint64_t GUID = 0;
+	bool HasInitializer = false;
+	// Analyzed during initialization: a pointer or container
+	bool IsInitCandidate = false;
+
+	// Facts of TyPM::findTargetTypesInInitializer()
+	vector<TypeRef> InitTypes;
+	vector<TypeRef> InitAllocTypes;
+	// GUIDs of external globals referenced by the initializer
+	vector<uint64_t> InitExternals;
+	// Fields of the initializer that hold declared functions or
+	// external globals; they count as stored only when the walk is
+	// for the module of the global
+	vector<typerefidx_t> InitStored;
+
+	// Facts of MLTA::typeConfineInInitializer()
+	vector<InitConfineSummary> InitConfines;
+	vector<TypeRef> InitCaps;
+
+	// Facts of TyPM::parseUsesOfGV(), in order
+	vector<GlobalUseSummary> Uses;
+};
+
+struct ModuleSummary {
+	string Name;
+	vector<TypeSummary> Types;
+	// Shape and name of each identified struct
+	vector<pair<uint64_t, string>> StructNames;
+	TypeRef Int8PtrTy = -1;
+	TypeRef IntPtrTy = -1;
+	// Functions with body and address-taken functions come first,
+	// in module order
+	vector<FuncSummary> Funcs;
+	vector<GlobalSummary> Globals;
+	// Fields of composite types that are stored to
+	vector<typerefidx_t> StoredTypeIdx;
+	// Allocations of target types
+	vector<TypeRef> AllocTypes;
+};
+
+//
+// Summary files, see -emit-summary and -from-summaries. A file holds
+// one module summary, behind a magic number and a format version; the
+// version must be bumped whenever a record above changes.
+//
+#define SUMMARY_MAGIC "TYPMSUM"
+#define SUMMARY_VERSION 3
+
+bool writeModuleSummary(ModuleSummary &S, string Path);
+// Returns false and sets Err if the file is not a valid summary
+bool readModuleSummary(string Path, ModuleSummary &S, string &Err);
+
+//
+// Builds the summary of a module. It runs the analysis routines of
+// MLTA and TyPM, and overrides the methods through which they report
+// facts, to record the module-local facts instead of applying them to
+// the global maps.
+//
+class SummaryBuilder : public TyPM {
+
+	private:
+		Module *CurM;
+		ModuleSummary *Sum;
+		DenseMap<Type *, TypeRef> TypeRefs;
+		DenseMap<Function *, FuncRef> FuncRefs;
+
+		TypeRef getTypeRef(Type *Ty);
+		TypeRef getPrintedTypeRef(Type *Ty);
+		FuncRef getFuncRef(Function *F);
+		void getChainSummary(TypeIdxList &Chain, bool Complete,
+				TypeChainSummary &CS);
+		void getChainSummary(Value *V, TypeChainSummary &CS);
+		void getSourceSummary(Instruction *I, SourceSummary &SS);
+
+		// The function or the global being analyzed
+		FuncRef CurFunc = -1;
+		GlobalSummary *CurGlobal = NULL;
+		set<pair<unsigned, TypeRef>> GlobalUses;
+
+		void escapeType(Value *V) override;
+		void propagateType(Value *ToV, Type *FromTy, int Idx) override;
+		void capType(Type *Ty) override;
+		void confineTargetFunction(Value *V, Function *F) override;
+		void confineInitializerTarget(Type *CTy, int Idx,
+				Function *F) override;
+		void confineArgTarget(Function *CF, unsigned OpNo,
+				Function *F) override;
+		void addGlobalUse(unsigned Kind, Type *Ty);
+		void addModuleToGVType(Type *Ty, Module *M,
+				GlobalVariable *GV) override;
+		void addGVToModuleType(Type *Ty, GlobalVariable *GV,
+				Module *M) override;
+		void addGVInitializerToModule(GlobalVariable *GV,
+				Module *M) override;
+		void addTargetAlloc(Type *Ty, Module *M) override;
+
+		void summarizeInitializer(GlobalVariable *GV, GlobalSummary &GS);
+		void summarizeArgs(Function *F, FuncRef R);
+		void summarizeCalls(Function *F, FuncRef R);
+		void summarizeICall(CallInst *CI, ICallSummary &IS);
+		void summarizeValueFlow(Value *V, ValueFlowSummary &VS);
+		void reset();
+
+	public:
+		SummaryBuilder(GlobalContext *Ctx_) : TyPM(Ctx_) { }
+
+		void summarize(Module *M, ModuleSummary &S);
+		// Hash of everything other than the module that a summary
+		// depends on: the format version, the analysis options and
+		// the target types
+		uint64_t getConfigHash();
+};
+
+#endif
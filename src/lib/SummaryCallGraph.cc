@@ -0,0 +1,1107 @@
+//===-- SummaryCallGraph.cc - Build call-graph from summaries ---===//
+//
+// This pass builds the global call-graph from module summaries. It
+// mirrors CallGraphPass step by step, so that the results are the
+// same as the ones of the analysis on the IR.
+//
+//===-----------------------------------------------------------===//
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <iomanip>
+
+#include "Common.h"
+#include "Config.h"
+#include "SummaryCallGraph.h"
+
+
+using namespace llvm;
+
+//
+// Printing from summaries, see printSourceCodeInfo() in Common.cc
+//
+static void printSourceInfo(const SourceSummary &Src,
+		const string &Text, string Tag) {
+
+	if (!Src.Valid)
+		return;
+
+	std::string FN = getSourcePath(Src.File);
+	string line = getSourceLine(FN, Src.Line);
+	FN = Src.File;
+
+	while(line[0] == ' ' || line[0] == '\t')
+		line.erase(line.begin());
+	OP << " ["
+		<< "\033[34m" << Tag << "\033[0m" << "] "
+		<< FN
+		<< " +" << Src.Line
+		<< " "
+		<< "\033[35m" << line << "\033[0m" <<'\n';
+	OP<<Text
+		<<"\n";
+}
+
+//
+// Implementation
+//
+
+SummaryCallGraph::SummaryCallGraph(GlobalContext *Ctx_,
+		vector<ModuleSummary> &Modules_) : Ctx(Ctx_), Modules(Modules_) {
+
+	LoadOutScopeFuncs(OutScopeFuncNames);
+
+	for (auto &S : Modules) {
+		for (auto &SN : S.StructNames)
+			ShapeStructNames[SN.first].insert(SN.second);
+	}
+
+	unsigned NumICalls = 0;
+	for (unsigned M = 0; M < Modules.size(); ++M) {
+		ModuleSummary &S = Modules[M];
+
+		FuncBase.push_back(FuncModule.size());
+		FuncModule.insert(FuncModule.end(), S.Funcs.size(), M);
+
+		ICallBase.push_back(NumICalls);
+		for (auto &F : S.Funcs) {
+			if (!F.IsDeclaration && !F.IsIntrinsic)
+				NumICalls += F.ICalls.size();
+		}
+
+		// Unnamed structs take the first name of the structs with the
+		// same shape, see typeHash()
+		vector<size_t> Hashes;
+		for (auto &TS : S.Types) {
+			if (!TS.Literal) {
+				Hashes.push_back(TS.Hash);
+				continue;
+			}
+			auto It = ShapeStructNames.find(TS.LiteralShape);
+			if (It != ShapeStructNames.end())
+				Hashes.push_back(strHash(*It->second.begin()));
+			else
+				Hashes.push_back(strHash(""));
+		}
+		TypeHashes.push_back(Hashes);
+
+		map<TypeRef, set<int>> Stored;
+		for (auto &TI : S.StoredTypeIdx)
+			Stored[TI.first].insert(TI.second);
+		storedTypeIdxMap.push_back(Stored);
+
+		for (unsigned G = 0; G < S.Globals.size(); ++G) {
+			if (S.Globals[G].HasInitializer)
+				Globals[S.Globals[G].GUID] = make_pair(M, G);
+		}
+	}
+
+	AnalysisPhase = 1;
+
+	time_t my_time = time(NULL);
+	OP<<"# TIME: "<<ctime(&my_time)<<"\n";
+}
+
+void SummaryCallGraph::getStructTypeHashes(unsigned M, TypeRef T,
+		set<size_t> &HSet) {
+
+	const TypeSummary &TS = getType(M, T);
+	if (TS.Kind != STK_Struct) {
+		HSet.insert(getTypeHash(M, T));
+		return;
+	}
+
+	// See structTypeHash()
+	if (!TS.Literal) {
+		HSet.insert(TS.Hash);
+		return;
+	}
+	auto It = ShapeStructNames.find(TS.LiteralShape);
+	if (It == ShapeStructNames.end())
+		return;
+	for (auto &Name : It->second)
+		HSet.insert(strHash(Name));
+}
+
+bool SummaryCallGraph::isContainerTy(unsigned M, TypeRef T) {
+	unsigned Kind = getType(M, T).Kind;
+	return (Kind == STK_Struct || Kind == STK_Array
+			|| Kind == STK_Vector);
+}
+
+TypeRef SummaryCallGraph::stripPointers(unsigned M, TypeRef T) {
+	while (getType(M, T).Kind == STK_Pointer)
+		T = getType(M, T).Pointee;
+	return T;
+}
+
+int SummaryCallGraph::getActualFunc(unsigned F) {
+
+	const FuncSummary &FS = getFunc(F);
+	if (!FS.IsDeclaration)
+		return F;
+
+	auto It = GlobalFuncMap.find(FS.GUID);
+	if (It == GlobalFuncMap.end())
+		return -1;
+	return It->second;
+}
+
+bool SummaryCallGraph::fuzzyTypeMatch(unsigned M1, TypeRef Ty1,
+		unsigned M2, TypeRef Ty2) {
+
+	if (M1 == M2 && Ty1 == Ty2)
+		return true;
+
+	while (getType(M1, Ty1).Kind == STK_Pointer
+			&& getType(M2, Ty2).Kind == STK_Pointer) {
+		Ty1 = getType(M1, Ty1).Pointee;
+		Ty2 = getType(M2, Ty2).Pointee;
+	}
+
+	const TypeSummary &T1 = getType(M1, Ty1);
+	const TypeSummary &T2 = getType(M2, Ty2);
+	if (T1.Kind == STK_Struct && T2.Kind == STK_Struct
+			&& T1.Name == T2.Name)
+		return true;
+	if (T1.Kind == STK_Integer && T2.Kind == STK_Integer
+			&& T1.Width == T2.Width)
+		return true;
+
+	// Types of different modules are never identical
+	if (
+			(Ty1 == Modules[M1].Int8PtrTy &&
+			 (T2.Kind == STK_Pointer || Ty2 == Modules[M2].IntPtrTy))
+			||
+			(M1 == M2 && Ty2 == Modules[M1].Int8PtrTy &&
+			 (T1.Kind == STK_Pointer || Ty1 == Modules[M2].IntPtrTy))
+	   )
+		return true;
+
+	return false;
+}
+
+// Caps added by MLTA::getBaseTypeChain()
+void SummaryCallGraph::applyChainCap(unsigned M,
+		const TypeChainSummary &Chain) {
+
+	if (!Chain.Types.empty() && !Chain.Complete)
+		typeFacts.cap(getTypeHash(M, Chain.Types.back().first));
+}
+
+void SummaryCallGraph::confineTargetFunction(unsigned M,
+		const TypeChainSummary &Chain, unsigned F) {
+
+	applyChainCap(M, Chain);
+	for (auto TI : Chain.Types)
+		typeFacts.addTarget(getTypeHash(M, TI.first), TI.second, F);
+	if (!Chain.Complete) {
+		if (!Chain.Types.empty())
+			typeFacts.cap(getTypeHash(M, Chain.Types.back().first));
+		else
+			typeFacts.cap(getFunc(F).Hash);
+	}
+}
+
+void SummaryCallGraph::propagateType(unsigned M,
+		const TypeChainSummary &Chain, typerefidx_t From) {
+
+	applyChainCap(M, Chain);
+	size_t FromH = getTypeHash(M, From.first);
+	for (auto T : Chain.Types) {
+		size_t TH = getTypeHash(M, T.first);
+		if (TH == FromH && T.second == From.second)
+			continue;
+
+		typeFacts.addProp(typeFacts.getField(TH, T.second),
+				typeFacts.getField(FromH, From.second));
+	}
+}
+
+void SummaryCallGraph::escapeType(unsigned M,
+		const TypeChainSummary &Chain) {
+
+	applyChainCap(M, Chain);
+	for (auto T : Chain.Types)
+		typeFacts.escape(typeFacts.getField(getTypeHash(M, T.first),
+					T.second));
+}
+
+void SummaryCallGraph::typeConfineInInitializer(unsigned M,
+		const GlobalSummary &GS) {
+
+	for (auto T : GS.InitCaps)
+		typeFacts.cap(getTypeHash(M, T));
+
+	for (auto &IC : GS.InitConfines) {
+		set<size_t> TyHS;
+		getStructTypeHashes(M, IC.Container, TyHS);
+		for (auto TyH : TyHS)
+			typeFacts.addTarget(TyH, IC.Idx, FuncBase[M] + IC.Func);
+	}
+}
+
+void SummaryCallGraph::typeConfineInFunction(unsigned M,
+		const FuncSummary &F) {
+
+	for (auto &C : F.Confines)
+		confineTargetFunction(M, C.Chain, FuncBase[M] + C.Func);
+
+	// Functions passed to declared functions, confined by the
+	// actual functions known so far
+	for (auto &AC : F.ArgConfines) {
+		const FuncSummary &CF = Modules[M].Funcs[AC.Callee];
+		auto It = GlobalFuncMap.find(CF.GUID);
+		if (It == GlobalFuncMap.end())
+			continue;
+		unsigned AF = It->second;
+		const FuncSummary &AFS = getFunc(AF);
+
+		// See getParamByArgNo()
+		int8_t ArgNo = AC.OperandNo;
+		if (ArgNo < 0 || (unsigned)ArgNo >= AFS.Args.size())
+			continue;
+		for (auto &Chain : AFS.Args[ArgNo].Confines)
+			confineTargetFunction(FuncModule[AF], Chain,
+					FuncBase[M] + AC.Func);
+	}
+}
+
+void SummaryCallGraph::typePropInFunction(unsigned M,
+		const FuncSummary &F) {
+
+	for (auto &P : F.Props) {
+		for (auto From : P.FromTypes)
+			propagateType(M, P.Chain, From);
+	}
+	for (auto &E : F.Escapes)
+		escapeType(M, E);
+}
+
+void SummaryCallGraph::getTargetsWithLayerType(fieldid_t F,
+		FuncIdSet &FS) {
+	typeFacts.getTargets(F, FS);
+}
+
+void SummaryCallGraph::getDependentTypes(fieldid_t F,
+		DenseSet<fieldid_t> &PropSet) {
+	typeFacts.getDependentFields(F, PropSet);
+}
+
+void SummaryCallGraph::findCalleesWithType(ICallRecord &IC,
+		FuncIdSet &S) {
+
+	const ICallSummary &IS = *IC.IS;
+
+	size_t CIH = IS.Hash;
+	auto It = MatchedFuncsMap.find(CIH);
+	if (It != MatchedFuncsMap.end()) {
+		S |= *It->second;
+		return;
+	}
+
+	unsigned CallerM = IC.M;
+	for (auto F : AddressTakenFuncs) {
+		const FuncSummary &FS = getFunc(F);
+		if (!FS.IsVarArg && FS.Args.size() != IS.ArgTys.size())
+			continue;
+		if (FS.IsIntrinsic)
+			continue;
+
+		if (IS.Hash == FS.Hash) {
+			S.insert(F);
+			continue;
+		}
+
+		unsigned CalleeM = FuncModule[F];
+
+		bool Matched = true;
+		for (unsigned i = 0; i < FS.Args.size(); ++i) {
+			// Beyond the args of a vararg call, the analysis on the IR
+			// reads the called value and then past the operands
+			TypeRef ActualTy;
+			if (i < IS.ArgTys.size())
+				ActualTy = IS.ArgTys[i];
+			else if (i == IS.ArgTys.size())
+				ActualTy = IS.CalledTy;
+			else {
+				Matched = false;
+				break;
+			}
+			if (!fuzzyTypeMatch(CalleeM, FS.Args[i].Ty, CallerM, ActualTy)) {
+				Matched = false;
+				break;
+			}
+		}
+
+		if (Matched) {
+			if (!fuzzyTypeMatch(CalleeM, FS.RetTy, CallerM, IS.RetTy))
+				Matched = false;
+		}
+
+		if (Matched)
+			S.insert(F);
+	}
+	MatchedFuncsMap[CIH] = CalleeSets.intern(S);
+}
+
+// See MLTA::findCalleesWithMLTA(). The layer types of the called value
+// are in the summary; a layer is only left when one of its types is
+// processed, as the IR version then moves on to the next value
+void SummaryCallGraph::findCalleesWithMLTA(ICallRecord &IC,
+		FuncIdSet &FS) {
+
+	const ICallSummary &IS = *IC.IS;
+	unsigned M = IC.M;
+
+	FS = sigFuncsMap[IS.Hash];
+	if (FS.empty())
+		return;
+
+	Ctx->NumFirstLayerTargets += FS.size();
+	Ctx->NumFirstLayerTypeCalls += 1;
+
+	FuncIdSet FS1, FS2;
+	size_t PrevLayerHash = getTypeHash(M, IS.FuncTy);
+	unsigned Layer = 0;
+	int LayerNo = 1;
+
+	bool ContinueNextLayer = true;
+	while (ContinueNextLayer) {
+
+		if (LayerNo >= MAX_TYPE_LAYER)
+			break;
+
+#ifdef SOUND_MODE
+		if (typeFacts.isCap(PrevLayerHash))
+			break;
+#endif
+
+		if (Layer >= IS.Layers.size())
+			break;
+
+		bool Moved = false;
+		for (auto TyIdx : IS.Layers[Layer]) {
+
+			if (LayerNo >= MAX_TYPE_LAYER)
+				break;
+			++LayerNo;
+
+			size_t TyH = getTypeHash(M, TyIdx.first);
+			fieldid_t TyIdxF = typeFacts.getField(TyH, TyIdx.second);
+			fieldid_t TyIdxF_1 = typeFacts.getField(TyH, -1);
+
+			if (MatchedFieldFuncsMap.find(TyIdxF) 
+					!= MatchedFieldFuncsMap.end()) {
+				FS1 = MatchedFieldFuncsMap[TyIdxF];
+			}
+			else {
+#ifdef SOUND_MODE
+				if (typeFacts.isEscaped(TyIdxF))
+					break;
+				if (typeFacts.isEscaped(TyIdxF_1))
+					break;
+#endif
+				getTargetsWithLayerType(TyIdxF, FS1);
+
+				DenseSet<fieldid_t> PropSet;
+				getDependentTypes(TyIdxF, PropSet);
+				for (auto Prop : PropSet) {
+					getTargetsWithLayerType(Prop, FS2);
+					FS1 |= FS2;
+				}
+				MatchedFieldFuncsMap[TyIdxF] = FS1;
+			}
+
+			FS.intersect(FS1, FS);
+			Moved = true;
+
+#ifdef SOUND_MODE
+			if (typeFacts.isCap(TyH)) {
+				ContinueNextLayer = false;
+				break;
+			}
+#endif
+
+			PrevLayerHash = TyH;
+		}
+		if (Moved)
+			++Layer;
+	}
+
+	if (LayerNo > 1) {
+		Ctx->NumSecondLayerTypeCalls++;
+		Ctx->NumSecondLayerTargets += FS.size();
+	}
+}
+
+const set<TypeRef> &SummaryCallGraph::findTargetTypesInInitializer(
+		unsigned GM, unsigned GIdx, unsigned M) {
+
+	static const set<TypeRef> NoTypes;
+	const GlobalSummary &GS = Modules[GM].Globals[GIdx];
+	if (!GS.HasInitializer)
+		return NoTypes;
+
+	auto Key = make_pair(GM, GIdx);
+	auto It = ParsedGlobalTypesMap.find(Key);
+	if (It != ParsedGlobalTypesMap.end())
+		return It->second;
+
+	set<TypeRef> TargetTypes;
+	for (auto GUID : GS.InitExternals) {
+		auto EIt = Globals.find(GUID);
+		if (EIt == Globals.end())
+			continue;
+		unsigned EM = EIt->second.first;
+
+		ParsedGlobalTypesMap[Key] = NoTypes;
+		const set<TypeRef> &ExternalTypes =
+			findTargetTypesInInitializer(EM, EIt->second.second, EM);
+
+		for (auto Ty : ExternalTypes)
+			moPropMap[make_pair(M, getTypeHash(EM, Ty))].set(EM);
+	}
+
+	for (auto Ty : GS.InitAllocTypes)
+		TargetDataAllocModules[getTypeHash(GM, Ty)].set(M);
+
+	// Stored fields keyed by types of another module never match
+	if (M == GM) {
+		for (auto TI : GS.InitStored)
+			storedTypeIdxMap[M][TI.first].insert(TI.second);
+	}
+
+	TargetTypes.insert(GS.InitTypes.begin(), GS.InitTypes.end());
+	for (auto Ty : TargetTypes) {
+		TypesFromModuleGVMap[make_pair(GS.GUID,
+				getTypeHash(GM, Ty))].set(M);
+	}
+
+	set<TypeRef> &Types = ParsedGlobalTypesMap[Key];
+	Types = std::move(TargetTypes);
+	return Types;
+}
+
+void SummaryCallGraph::parseUsesOfGV(unsigned M, const GlobalSummary &GS) {
+
+	for (auto &U : GS.Uses) {
+		if (U.Kind == GUK_FromModule) {
+			TypesFromModuleGVMap[make_pair(GS.GUID,
+					getTypeHash(M, U.Ty))].set(M);
+		}
+		else if (U.Kind == GUK_ToModule) {
+			TypesToModuleGVMap[make_pair(GS.GUID,
+					getTypeHash(M, U.Ty))].set(M);
+		}
+		else {
+			auto EIt = Globals.find(GS.GUID);
+			if (EIt == Globals.end())
+				continue;
+			unsigned EM = EIt->second.first;
+
+			const set<TypeRef> &TySet =
+				findTargetTypesInInitializer(EM, EIt->second.second, M);
+			for (auto Ty : TySet) {
+				TypesToModuleGVMap[make_pair(GS.GUID,
+						getTypeHash(EM, Ty))].set(M);
+			}
+		}
+	}
+}
+
+void SummaryCallGraph::addPropagation(unsigned ToM, unsigned FromM,
+		size_t TyH, bool isICall) {
+
+	if (isICall)
+		moPropMapV[make_pair(ToM, TyH)].set(FromM);
+	else
+		moPropMap[make_pair(ToM, TyH)].set(FromM);
+}
+
+void SummaryCallGraph::parseTargetTypesInCalls(unsigned CallerM,
+		const FuncSummary &Caller, const CallSummary &CS,
+		unsigned CF, bool isICall) {
+
+	unsigned CalleeM = FuncModule[CF];
+	const FuncSummary &Callee = getFunc(CF);
+
+	auto MP = make_pair(CallerM, CalleeM);
+	auto &ParsedTypes = isICall ?
+		ParsedModuleTypeICallMap[MP] : ParsedModuleTypeDCallMap[MP];
+
+	for (unsigned ArgNo = 0; ArgNo < Callee.Args.size(); ++ArgNo) {
+
+		const ArgSummary &Arg = Callee.Args[ArgNo];
+
+		if (Arg.IsTarget) {
+			addPropagation(CalleeM, CallerM,
+					getTypeHash(CalleeM, Arg.Ty), isICall);
+		}
+		else if (Arg.TargetElemTy != -1) {
+			size_t ETyH = getTypeHash(CalleeM, Arg.TargetElemTy);
+
+			// Functions passed as the argument
+			for (auto AF : CS.ArgFuncs) {
+				if (AF.first != ArgNo)
+					continue;
+				int F = getActualFunc(FuncBase[CallerM] + AF.second);
+				if (F != -1)
+					addPropagation(CallerM, FuncModule[F], ETyH, isICall);
+			}
+
+			addPropagation(CalleeM, CallerM, ETyH, isICall);
+		}
+
+		const ValueFlowSummary &Flow = Arg.Flow;
+		if (Flow.Parsable) {
+#ifdef FLOW_DIRECTION
+			if (!Callee.OnlyWritesMemory) {
+#endif
+				for (auto Ty : Flow.ReadTypes) {
+					addPropagation(CalleeM, CallerM,
+							getTypeHash(CalleeM, Ty), isICall);
+				}
+#ifdef FLOW_DIRECTION
+			}
+			if (!Callee.OnlyReadsMemory) {
+#endif
+				for (auto Ty : Flow.WrittenTypes) {
+					addPropagation(CallerM, CalleeM,
+							getTypeHash(CalleeM, Ty), isICall);
+				}
+#ifdef FLOW_DIRECTION
+			}
+#endif
+		}
+		else {
+
+			// Avoid repeatation for performance
+			if (!ParsedTypes.insert(make_pair(CalleeM, Arg.Ty)).second)
+				continue;
+
+#ifdef FLOW_DIRECTION
+			if (!Callee.OnlyWritesMemory) {
+#endif
+				for (auto Ty : Flow.TargetTypes) {
+					addPropagation(CalleeM, CallerM,
+							getTypeHash(CalleeM, Ty), isICall);
+				}
+#ifdef FLOW_DIRECTION
+			}
+			if (!Callee.OnlyReadsMemory) {
+#endif
+				for (auto Ty : Flow.TargetTypes) {
+					addPropagation(CallerM, CalleeM,
+							getTypeHash(CalleeM, Ty), isICall);
+				}
+#ifdef FLOW_DIRECTION
+			}
+#endif
+		}
+	}
+
+	// Parsing return values
+	const ValueFlowSummary &Flow = CS.RetFlow;
+	if (Flow.Parsable) {
+#ifdef FLOW_DIRECTION
+		if (!Caller.OnlyWritesMemory) {
+#endif
+			for (auto Ty : Flow.ReadTypes) {
+				addPropagation(CallerM, CalleeM,
+						getTypeHash(CallerM, Ty), isICall);
+			}
+#ifdef FLOW_DIRECTION
+		}
+		if (!Caller.OnlyReadsMemory) {
+#endif
+			for (auto Ty : Flow.WrittenTypes) {
+				addPropagation(CalleeM, CallerM,
+						getTypeHash(CallerM, Ty), isICall);
+			}
+#ifdef FLOW_DIRECTION
+		}
+#endif
+	}
+	else {
+		// Avoid repeatation for performance
+		if (!ParsedTypes.insert(make_pair(CallerM, CS.RetTy)).second)
+			return;
+
+		for (auto Ty : Flow.TargetTypes) {
+			size_t TyH = getTypeHash(CallerM, Ty);
+#ifdef FLOW_DIRECTION
+			if (!Caller.OnlyWritesMemory) {
+#endif
+				addPropagation(CallerM, CalleeM, TyH, isICall);
+#ifdef FLOW_DIRECTION
+			}
+			else if (!Caller.OnlyReadsMemory) {
+#endif
+				addPropagation(CalleeM, CallerM, TyH, isICall);
+#ifdef FLOW_DIRECTION
+			}
+#endif
+		}
+	}
+}
+
+void SummaryCallGraph::mapDeclToActualFuncs(FuncIdSet &FS) {
+
+	SmallVector<unsigned, 16> Mapped;
+	for (auto F : FS) {
+		int AF = getActualFunc(F);
+		if (AF != -1)
+			Mapped.push_back(AF);
+	}
+	FS.clear();
+	FS.insert(Mapped.begin(), Mapped.end());
+}
+
+const ModuleSet &SummaryCallGraph::getDependentModulesV(ICallRecord &IC) {
+
+	const ICallSummary &IS = *IC.IS;
+	unsigned M = IC.M;
+
+	// Externality check of the outermost layer type, see
+	// TyPM::getDependentModulesV()
+	bool Elevated = false;
+	if (IS.OuterTy != -1) {
+		auto It = storedTypeIdxMap[M].find(IS.OuterTy);
+		Elevated = !(It != storedTypeIdxMap[M].end() &&
+				(It->second.count(IS.OuterIdx) || IS.OuterIdx == -1));
+	}
+
+#ifndef TYPE_ELEVATION // disable type elevation?
+	Elevated = false;
+#endif
+
+	TypeRef TTy = IS.CalledTy;
+	if (Elevated) {
+		TTy = IS.OuterTy;
+		OP<<"@@ Elevated type: "<<getType(M, IS.CalledTy).Text
+			<<" ==> "<<getType(M, TTy).Text<<"\n";
+		OP<<"@@ Field index: "<<IS.OuterIdx<<"\n";
+	}
+	TTy = stripPointers(M, TTy);
+
+	size_t TyH = getTypeHash(M, TTy);
+	const ModuleSet &MSet = getDependentModulesTy(TyH, M);
+	if (MSet.empty() && isContainerTy(M, TTy)) {
+		if (storedTypeIdxMap[M].find(TTy) == storedTypeIdxMap[M].end()) {
+			if (!TargetDataAllocModules[TyH].test(M)) {
+				OP<<"!!! NO DEPENDENCE: "<<getType(M, TTy).Text<<"\n";
+				printSourceInfo(IS.CalledSrc, IS.CalledText, "TYPE-ERR");
+			}
+		}
+	}
+	return MSet;
+}
+
+const ModuleSet &SummaryCallGraph::getDependentModulesTy(size_t TyH,
+		unsigned M) {
+	return DepModules.get(TyH, M);
+}
+
+void SummaryCallGraph::buildDependentModules() {
+
+	// Modules passing general pointers
+	vector<size_t> HubTypes;
+	for (unsigned M = 0; M < Modules.size(); ++M)
+		HubTypes.push_back(getTypeHash(M, Modules[M].Int8PtrTy));
+	DepModules.build(moPropMapAll, HubTypes);
+}
+
+bool SummaryCallGraph::resolveFunctionTargets() {
+
+	uint64_t oldCount = 0, newCount = 0, outScopeCount = 0;
+	uint64_t oldModuleCount = 0, newModuleCount = 0;
+
+	for (auto &IC : ICalls) {
+
+		// Prune a copy; the set is shared with other calls
+		FuncIdSet Callees = *IC.Callees;
+		oldCount += Callees.size();
+		oldModuleCount += Modules.size();
+		// The caller module counts as a dependent module
+		const ModuleSet &MSet = getDependentModulesV(IC);
+		newModuleCount += MSet.count() + !MSet.test(IC.M);
+
+#ifdef PRINT_ICALL_TARGET
+		printSourceInfo(IC.IS->Src, IC.IS->Text, "RESOLVING");
+#endif
+		Callees.remove_if([&](unsigned Callee) {
+			if (FuncModule[Callee] == IC.M || MSet.test(FuncModule[Callee])) {
+				newCount += 1;
+				return false;
+			}
+			if (OutScopeFuncNames.find(getFunc(Callee).Name)
+					== OutScopeFuncNames.end()) {
+#ifdef PRINT_ICALL_TARGET
+				printSourceCodeInfo(Callee, "REMOVED");
+#endif
+				return true;
+			}
+			outScopeCount += 1;
+			return false;
+		});
+		mapDeclToActualFuncs(Callees);
+		IC.Callees = CalleeSets.intern(Callees);
+#ifdef PRINT_ICALL_TARGET
+		printTargets(IC);
+#endif
+	}
+	if (Ctx->NumIndirectCallTargets > 0) {
+		time_t my_time = time(NULL);
+		OP<<"# TIME: "<<ctime(&my_time)<<"\n";
+		cout<<"\n@@ Target Reduction: "
+			<<newCount<<"/"<<oldCount<<"/"
+			<<Ctx->NumIndirectCallTargets<< ", Reduction Rate: "
+			<<std::setprecision(5)
+			<<((Ctx->NumIndirectCallTargets - newCount)*(float)100)/Ctx->NumIndirectCallTargets<<"\%\n";
+	}
+	if (oldModuleCount > 0) {
+		cout<<"@@ Module Reduction: "
+			<<newModuleCount<<"/"<<oldModuleCount<<", Reduction Rate: "
+			<<std::setprecision(5)
+			<<((oldModuleCount - newModuleCount)*(float)100)/oldModuleCount<<"\%\n\n";
+	}
+	cout<<"@@ Out-of-scope Count: "<<outScopeCount<<"\n\n";
+	if (newCount + outScopeCount == oldCount) {
+		// Done with the iteration
+		return false;
+	}
+	return true;
+}
+
+void SummaryCallGraph::printSourceCodeInfo(unsigned F, string Tag) {
+
+	const FuncSummary &FS = getFunc(F);
+
+	if (FS.Src.Valid) {
+		// For the warning on the source path only
+		getSourcePath(FS.Src.File);
+
+		OP << " ["
+			<< "\033[34m" << Tag << "\033[0m" << "] "
+			<< FS.Src.File
+			<< " +" << FS.Src.Line
+#ifdef PRINT_SOURCE_LINE
+			<< " "
+			<< FS.Name
+#endif
+			<<'\n';
+	}
+#ifdef PRINT_SOURCE_LINE
+	else {
+		OP << " ["
+			<< "\033[34m" << "??" << "\033[0m" << "] "
+			<< FS.Name<<'\n';
+	}
+#endif
+}
+
+void SummaryCallGraph::printTargets(ICallRecord &IC) {
+
+	const ICallSummary &IS = *IC.IS;
+#ifdef PRINT_SOURCE_LINE
+	OP<<"[CallGraph] Indirect call: "<<IS.Text<<"\n";
+	OP<<Modules[IC.M].Name<<"\n";
+#endif
+	printSourceInfo(IS.Src, IS.Text, "CALLER");
+
+	OP<<"\n\t Indirect-call targets: ("<<IC.Callees->size()<<")\n";
+	for (auto F : *IC.Callees) {
+		const FuncSummary &FS = getFunc(F);
+		if (FS.IsDeclaration) {
+			OP<<"ERROR: print declaration function: "<<FS.Name<<"\n";
+			continue;
+		}
+		printSourceCodeInfo(F, "TARGET");
+	}
+	OP<<"\n";
+}
+
+void SummaryCallGraph::PhaseMLTA(unsigned M, const FuncSummary &F) {
+
+	for (auto &CS : F.Calls) {
+		if (CS.ICall == -1)
+			continue;
+
+		ICallRecord IC;
+		IC.M = M;
+		IC.IS = &F.ICalls[CS.ICall];
+		const ICallSummary &IS = *IC.IS;
+
+		// Multi-layer type matching
+		if (ENABLE_MLTA > 1) {
+			FuncIdSet Targets;
+			findCalleesWithMLTA(IC, Targets);
+			IC.Callees = CalleeSets.intern(Targets);
+		}
+		// Fuzzy type matching
+		else if (ENABLE_MLTA == 0) {
+			auto It = MatchedICallTypeMap.find(IS.Hash);
+			if (It != MatchedICallTypeMap.end())
+				IC.Callees = It->second;
+			else {
+				FuncIdSet Targets;
+				findCalleesWithType(IC, Targets);
+				IC.Callees = CalleeSets.intern(Targets);
+				MatchedICallTypeMap[IS.Hash] = IC.Callees;
+			}
+		}
+		// One-layer type matching
+		else {
+			IC.Callees = CalleeSets.intern(sigFuncsMap[IS.Hash]);
+		}
+
+		if (!IC.Callees->empty()) {
+			Ctx->NumIndirectCallTargets += IC.Callees->size();
+			Ctx->NumValidIndirectCalls++;
+		}
+		ICalls.push_back(IC);
+	}
+}
+
+void SummaryCallGraph::PhaseTyPM(unsigned M, const FuncSummary &F,
+		unsigned &ICallIdx) {
+
+	for (auto &CS : F.Calls) {
+
+		// Indirect call
+		if (CS.ICall != -1) {
+			ICallRecord &IC = ICalls[ICallIdx++];
+			if (IC.IS->ArgTys.empty())
+				continue;
+
+			for (auto Callee : *IC.Callees) {
+				// Need to use the actual function with body here
+				int CF = getActualFunc(Callee);
+				if (CF == -1)
+					continue;
+				if (getFunc(CF).DoesNotAccessMemory)
+					continue;
+
+				parseTargetTypesInCalls(M, F, CS, CF, true);
+			}
+		}
+
+		// Direct call, no need to repeat for following iterations
+		else if (AnalysisPhase == 2) {
+			int CF = getActualFunc(FuncBase[M] + CS.Callee);
+			if (CF == -1)
+				continue;
+			if (getFunc(CF).DoesNotAccessMemory)
+				continue;
+
+			parseTargetTypesInCalls(M, F, CS, CF, false);
+		}
+	}
+}
+
+void SummaryCallGraph::doInitialization(unsigned M) {
+
+	ModuleSummary &S = Modules[M];
+
+	OP<<"#"<<M<<" Initializing: "<<S.Name<<"\n";
+
+	for (unsigned G = 0; G < S.Globals.size(); ++G) {
+		GlobalSummary &GS = S.Globals[G];
+		if (!GS.IsInitCandidate)
+			continue;
+
+		findTargetTypesInInitializer(M, G, M);
+		typeConfineInInitializer(M, GS);
+	}
+
+	for (unsigned R = 0; R < S.Funcs.size(); ++R) {
+
+		FuncSummary &F = S.Funcs[R];
+		if (F.IsIntrinsic)
+			continue;
+
+		unsigned ID = FuncBase[M] + R;
+		if (F.HasAddressTaken) {
+			AddressTakenFuncs.insert(ID);
+			sigFuncsMap[F.Hash].insert(ID);
+			StringRef FName = F.Name;
+			if (FName.startswith("__x64") ||
+					FName.startswith("__ia32") ||
+					FName.startswith("__do_sys")) {
+				OutScopeFuncNames.insert(F.Name);
+			}
+		}
+
+		if (F.IsDeclaration)
+			continue;
+		++Ctx->NumFunctions;
+
+		if (F.HasExternalLinkage)
+			GlobalFuncMap[F.GUID] = ID;
+
+		if (ENABLE_MLTA > 1)
+			typePropInFunction(M, F);
+
+		typeConfineInFunction(M, F);
+	}
+
+	for (auto Ty : S.AllocTypes)
+		TargetDataAllocModules[getTypeHash(M, Ty)].set(M);
+
+	if (M == Modules.size() - 1)
+		typeFacts.flushTargets();
+	if (M == Modules.size() - 1 && ENABLE_MLTA > 1) {
+		// Map the declaration functions to actual ones
+		for (auto &SF : sigFuncsMap)
+			mapDeclToActualFuncs(SF.second);
+		for (auto &FS : typeFacts.FieldTargets)
+			mapDeclToActualFuncs(FS);
+	}
+}
+
+bool SummaryCallGraph::doModulePass(unsigned M) {
+
+	ModuleSummary &S = Modules[M];
+	bool Last = (M == Modules.size() - 1);
+
+	if (AnalysisPhase == 1) {
+		for (auto &GS : S.Globals)
+			parseUsesOfGV(M, GS);
+
+		if (Last) {
+			// Use globals to connect modules
+			for (auto &GMM : TypesToModuleGVMap) {
+				for (auto DstM : GMM.second) {
+					size_t TyH = GMM.first.second;
+					moPropMap[make_pair(DstM, TyH)] |=
+						TypesFromModuleGVMap[GMM.first];
+				}
+			}
+		}
+	}
+
+	unsigned ICallIdx = ICallBase[M];
+	for (auto &F : S.Funcs) {
+		if (F.IsDeclaration || F.IsIntrinsic)
+			continue;
+
+		if (AnalysisPhase == 1)
+			PhaseMLTA(M, F);
+		else
+			PhaseTyPM(M, F, ICallIdx);
+	}
+
+	if (!Last)
+		return false;
+
+	if (AnalysisPhase == 2) {
+		TypesFromModuleGVMap.clear();
+		TypesToModuleGVMap.clear();
+	}
+
+	if (AnalysisPhase >= 2) {
+
+		// Merge the propagation maps
+		moPropMapAll.insert(moPropMap.begin(), moPropMap.end());
+		for (auto &m : moPropMapV)
+			moPropMapAll[m.first] |= m.second;
+		buildDependentModules();
+
+#ifdef FUNCTION_AS_TARGET_TYPE
+		bool NextIter = resolveFunctionTargets();
+#else
+		// Struct target types are only supported on the IR; main()
+		// rejects the summary modes in this configuration
+		bool NextIter = false;
+#endif
+		if (!NextIter)
+			return false;
+
+		moPropMapV.clear();
+		DepModules.clear();
+		moPropMapAll.clear();
+		ParsedModuleTypeICallMap.clear();
+		ParsedModuleTypeDCallMap.clear();
+		PhaseArena::reset();
+	}
+
+	++AnalysisPhase;
+	if (AnalysisPhase <= MAX_PHASE_CG) {
+		OP<<"\n\n=== Move to phase "<<AnalysisPhase<<" ===\n\n";
+		return true;
+	}
+
+	return false;
+}
+
+void SummaryCallGraph::doFinalization() {
+
+	OP<<"Mapping declaration functions to actual ones...\n";
+	Ctx->NumIndirectCallTargets = 0;
+	for (auto &IC : ICalls) {
+		FuncIdSet Callees = *IC.Callees;
+		mapDeclToActualFuncs(Callees);
+		IC.Callees = CalleeSets.intern(Callees);
+		Ctx->NumIndirectCallTargets += Callees.size();
+		printTargets(IC);
+	}
+}
+
+// Same output as IterativeModulePass::run()
+void SummaryCallGraph::run() {
+
+	OP << "[CallGraph] Initializing " << Modules.size() << " modules ";
+	for (unsigned M = 0; M < Modules.size(); ++M) {
+		doInitialization(M);
+		OP << ".";
+	}
+	OP << "\n";
+
+	unsigned iter = 0, changed = 1;
+	while (changed) {
+		++iter;
+		changed = 0;
+		for (unsigned M = 0; M < Modules.size(); ++M) {
+			OP << "[CallGraph / " << iter << "] ";
+			OP << "[" << M + 1 << " / " << Modules.size() << "] ";
+			OP << "[" << Modules[M].Name << "]\n";
+
+			if (doModulePass(M)) {
+				++changed;
+				OP << "\t [CHANGED]\n";
+			} else
+				OP << "\n";
+		}
+		OP << "[CallGraph] Updated in " << changed << " modules.\n";
+	}
+
+	OP << "[CallGraph] Postprocessing ...\n";
+	doFinalization();
+	OP << "[CallGraph] Done!\n\n";
+}
+
+// Same output as PrintResults() in Analyzer.cc
+void SummaryCallGraph::printResults() {
+
+	float AveIndirectTargets = 0.0;
+	if (Ctx->NumValidIndirectCalls)
+		AveIndirectTargets =
+			(float)Ctx->NumIndirectCallTargets/ICalls.size();
+
+	int totalsize = 0;
+	for (auto &IC : ICalls)
+		totalsize += IC.Callees->size();
+	OP << "\n@@ Total number of final callees: " << totalsize << "\n";
+
+	OP<<"############## Result Statistics ##############\n";
+	cout<<"# Ave. Number of indirect-call targets: \t"<<std::setprecision(5)<<AveIndirectTargets<<"\n";
+	OP<<"# Number of indirect calls: \t\t\t"<<ICalls.size()<<"\n";
+	OP<<"# Number of indirect calls with targets: \t"<<Ctx->NumValidIndirectCalls<<"\n";
+	OP<<"# Number of indirect-call targets: \t\t"<<Ctx->NumIndirectCallTargets<<"\n";
+	OP<<"# Number of address-taken functions: \t\t"<<AddressTakenFuncs.size()<<"\n";
+	OP<<"# Number of second layer calls: \t\t"<<Ctx->NumSecondLayerTypeCalls<<"\n";
+	OP<<"# Number of second layer targets: \t\t"<<Ctx->NumSecondLayerTargets<<"\n";
+	OP<<"# Number of first layer calls: \t\t\t"<<Ctx->NumFirstLayerTypeCalls<<"\n";
+	OP<<"# Number of first layer targets: \t\t"<<Ctx->NumFirstLayerTargets<<"\n";
+}
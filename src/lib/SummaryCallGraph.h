@@ -0,0 +1,159 @@
+#ifndef _SUMMARY_CALL_GRAPH_H
+#define _SUMMARY_CALL_GRAPH_H
+
+#include "Analyzer.h"
+#include "MLTA.h"
+#include "ModuleClosure.h"
+#include "Summary.h"
+#include "Config.h"
+#include <time.h>
+
+//
+// The call-graph pass on module summaries. It runs the same phases as
+// CallGraphPass, in the same order, but all facts come from the
+// summaries, so no module has to stay in memory. Modules are referred
+// to by their index, and functions by their global ID: the index of
+// the first function of the module plus the FuncRef.
+//
+typedef IDSet<IdentityIDMap> FuncIdSet;
+
+class SummaryCallGraph {
+
+	private:
+
+		//
+		// Variables
+		//
+
+		GlobalContext *Ctx;
+		vector<ModuleSummary> &Modules;
+
+		// Global ID of the first function of each module
+		vector<unsigned> FuncBase;
+		// Module of each function
+		vector<unsigned> FuncModule;
+		// Resolved typeHash() of each type of each module
+		vector<vector<size_t>> TypeHashes;
+		// Names of identified structs by shape, for unnamed structs
+		DenseMap<uint64_t, set<string>> ShapeStructNames;
+		// Global GUID to the module and index of its initializer
+		map<uint64_t, pair<unsigned, unsigned>> Globals;
+
+		// MLTA, see MLTA.h
+		map<uint64_t, unsigned> GlobalFuncMap;
+		FuncIdSet AddressTakenFuncs;
+		unordered_map<size_t, FuncIdSet> sigFuncsMap;
+		TypeFieldFacts<FuncIdSet> typeFacts;
+		unordered_map<size_t, const FuncIdSet *> MatchedFuncsMap;
+		unordered_map<fieldid_t, FuncIdSet> MatchedFieldFuncsMap;
+		unordered_map<size_t, const FuncIdSet *> MatchedICallTypeMap;
+
+		// TyPM, see TyPM.h
+		typedef pair<unsigned, size_t> modtype_t;
+		set<string> OutScopeFuncNames;
+		unordered_map<size_t, ModuleSet> TargetDataAllocModules;
+		map<modtype_t, ModuleSet> moPropMap;
+		map<modtype_t, ModuleSet> moPropMapV;
+		map<modtype_t, ModuleSet> moPropMapAll;
+		vector<map<TypeRef, set<int>>> storedTypeIdxMap;
+		map<pair<uint64_t, size_t>, ModuleSet> TypesFromModuleGVMap;
+		map<pair<uint64_t, size_t>, ModuleSet> TypesToModuleGVMap;
+		map<pair<unsigned, unsigned>, set<TypeRef>> ParsedGlobalTypesMap;
+		// Caches of the phases >= 2, see PhaseArena
+		ModuleClosure DepModules;
+		map<pair<unsigned, unsigned>,
+			ArenaSet<pair<unsigned, TypeRef>, PhaseArena>>
+				ParsedModuleTypeICallMap;
+		map<pair<unsigned, unsigned>,
+			ArenaSet<pair<unsigned, TypeRef>, PhaseArena>>
+				ParsedModuleTypeDCallMap;
+
+		// Indirect calls, in the order of the modules, functions, and
+		// calls, with their targets; the target sets are shared
+		struct ICallRecord {
+			unsigned M;
+			const ICallSummary *IS;
+			const FuncIdSet *Callees;
+		};
+		IDSetPool<IdentityIDMap> CalleeSets;
+		vector<ICallRecord> ICalls;
+		// Index of the first indirect call of each module
+		vector<unsigned> ICallBase;
+
+		int AnalysisPhase;
+
+
+		//
+		// Methods
+		//
+
+		const FuncSummary &getFunc(unsigned F) {
+			return Modules[FuncModule[F]].Funcs[F - FuncBase[FuncModule[F]]];
+		}
+		const TypeSummary &getType(unsigned M, TypeRef T) {
+			return Modules[M].Types[T];
+		}
+		size_t getTypeHash(unsigned M, TypeRef T) {
+			return TypeHashes[M][T];
+		}
+		void getStructTypeHashes(unsigned M, TypeRef T, set<size_t> &HSet);
+		bool isContainerTy(unsigned M, TypeRef T);
+		TypeRef stripPointers(unsigned M, TypeRef T);
+		// The actual function of a declaration, or -1
+		int getActualFunc(unsigned F);
+
+		// MLTA
+		bool fuzzyTypeMatch(unsigned M1, TypeRef Ty1,
+				unsigned M2, TypeRef Ty2);
+		void applyChainCap(unsigned M, const TypeChainSummary &Chain);
+		void confineTargetFunction(unsigned M,
+				const TypeChainSummary &Chain, unsigned F);
+		void propagateType(unsigned M, const TypeChainSummary &Chain,
+				typerefidx_t From);
+		void escapeType(unsigned M, const TypeChainSummary &Chain);
+		void typeConfineInInitializer(unsigned M, const GlobalSummary &GS);
+		void typeConfineInFunction(unsigned M, const FuncSummary &F);
+		void typePropInFunction(unsigned M, const FuncSummary &F);
+		void getTargetsWithLayerType(fieldid_t F, FuncIdSet &FS);
+		void getDependentTypes(fieldid_t F, DenseSet<fieldid_t> &PropSet);
+		void findCalleesWithType(ICallRecord &IC, FuncIdSet &S);
+		void findCalleesWithMLTA(ICallRecord &IC, FuncIdSet &FS);
+
+		// TyPM
+		const set<TypeRef> &findTargetTypesInInitializer(unsigned GM,
+				unsigned GIdx, unsigned M);
+		void parseUsesOfGV(unsigned M, const GlobalSummary &GS);
+		void addPropagation(unsigned ToM, unsigned FromM, size_t TyH,
+				bool isICall);
+		void parseTargetTypesInCalls(unsigned CallerM,
+				const FuncSummary &Caller, const CallSummary &CS,
+				unsigned CF, bool isICall);
+		void mapDeclToActualFuncs(FuncIdSet &FS);
+		const ModuleSet &getDependentModulesV(ICallRecord &IC);
+		const ModuleSet &getDependentModulesTy(size_t TyH, unsigned M);
+		void buildDependentModules();
+		bool resolveFunctionTargets();
+
+		// Printing
+		void printTargets(ICallRecord &IC);
+		void printSourceCodeInfo(unsigned F, string Tag);
+
+		// Phases
+		void PhaseMLTA(unsigned M, const FuncSummary &F);
+		void PhaseTyPM(unsigned M, const FuncSummary &F,
+				unsigned &ICallIdx);
+
+		void doInitialization(unsigned M);
+		bool doModulePass(unsigned M);
+		void doFinalization();
+
+	public:
+
+		SummaryCallGraph(GlobalContext *Ctx_,
+				vector<ModuleSummary> &Modules_);
+
+		void run();
+		void printResults();
+};
+
+#endif
@@ -39,9 +39,7 @@ using namespace llvm;
 //
 // Static variables
 //
-DenseMap<pair<Module*, size_t>, set<Module*>> TyPM::moPropMapAll;
-
-extern map<Module *, Type *>Int8PtrTy;
+DenseMap<pair<unsigned, size_t>, ModuleSet> TyPM::moPropMapAll;
 
 //
 // Implementation
@@ -88,10 +86,11 @@ void TyPM::addPropagation(Module *ToM, Module *FromM, Type *Ty,
 			<<FromM->getName()<<" ==> "<<ToM->getName()
 			<<" HASH: "<<TyH<<"\n";
 #endif
+	unsigned ToID = Ctx->getModuleID(ToM);
 	if (isICall)
-		moPropMapV[make_pair(ToM, TyH)].insert(FromM);
+		moPropMapV[make_pair(ToID, TyH)].set(Ctx->getModuleID(FromM));
 	else
-		moPropMap[make_pair(ToM, TyH)].insert(FromM);
+		moPropMap[make_pair(ToID, TyH)].set(Ctx->getModuleID(FromM));
 }
 
 void TyPM::addModuleToGVType(Type *Ty, Module *M, GlobalVariable *GV) {
@@ -101,7 +100,7 @@ void TyPM::addModuleToGVType(Type *Ty, Module *M, GlobalVariable *GV) {
 		<<" <== "<<M->getName()<<" HASH: "<<typeHash(Ty)<<"\n";
 #endif
 	TypesFromModuleGVMap[make_pair(GV->getGUID(), 
-			typeHash(Ty))].insert(M);
+			typeHash(Ty))].set(Ctx->getModuleID(M));
 }
 
 
@@ -112,7 +111,23 @@ void TyPM::addGVToModuleType(Type *Ty, GlobalVariable *GV, Module *M) {
 		<<" ==> "<<M->getName()<<" HASH: "<<typeHash(Ty)<<"\n";
 #endif
 	TypesToModuleGVMap[make_pair(GV->getGUID(), 
-			typeHash(Ty))].insert(M);
+			typeHash(Ty))].set(Ctx->getModuleID(M));
+}
+
+// The global is passed to a call, so the types of its initializer
+// flow to the module
+void TyPM::addGVInitializerToModule(GlobalVariable *GV, Module *M) {
+	GlobalVariable *EGV = Ctx->getGlobalDef(GV);
+	if (EGV && EGV->hasInitializer()) {
+		const TypeList &TySet = findTargetTypesInInitializer(EGV, M);
+		for (auto Ty : TySet) {
+			addGVToModuleType(Ty, GV, M);
+		}
+	}
+}
+
+void TyPM::addTargetAlloc(Type *Ty, Module *M) {
+	TargetDataAllocModules[typeHash(Ty)].set(Ctx->getModuleID(M));
 }
 
 
@@ -208,13 +223,14 @@ void TyPM::findCastsInFunction(Function *F,
 
 void TyPM::processCasts(set<User *> &CastSet, Module *M) {
 
+	ModuleInfo &MI = getModuleInfo(M);
 	for (auto CO : CastSet) {
 		Type *TyFrom = CO->getOperand(0)->getType();
 		Type *TyTo = CO->getType();
 		// The following filters are a bit aggressive
 		if (!TyFrom->isPointerTy() || !TyTo->isPointerTy())
 			continue;
-		if (TyFrom != Int8PtrTy[M] && TyTo != Int8PtrTy[M])
+		if (TyFrom != MI.Int8PtrTy && TyTo != MI.Int8PtrTy)
 			continue;
 
 		Type *ETyFrom = TyFrom->getPointerElementType();
@@ -227,8 +243,8 @@ void TyPM::processCasts(set<User *> &CastSet, Module *M) {
 
 		Type *BTyFrom = TyFrom, *BTyTo = TyTo;
 		if (BTyFrom && BTyTo) {
-			CastFromMap[M][TyTo].insert(TyFrom);
-			CastToMap[M][TyFrom].insert(TyTo);
+			MI.CastFrom[TyTo].insert(TyFrom);
+			MI.CastTo[TyFrom].insert(TyTo);
 		}
 	}
 }
@@ -243,21 +259,18 @@ void TyPM::processCasts(set<User *> &CastSet, Module *M) {
 //
 /////////////////////////////////////////////////////////////////////
 
-void TyPM::findTargetTypesInInitializer(GlobalVariable * GV, 
-		Module *M, set<Type *> &TargetTypes) {
-
-	Constant *Ini = GV->getInitializer();
-	if (!Ini) return;
-	// The global can be a pointer to another global; in this case, we
-	// still need to look into it, so comment out the following line
-	//if (!isa<ConstantAggregate>(Ini)) return;
+const TypeList *TyPM::internTypes(const set<Type *> &Types) {
+	return &*TypeLists.insert(TypeList(Types.begin(), Types.end())).first;
+}
 
-	if (ParsedGlobalTypesMap.find(GV) 
-			!= ParsedGlobalTypesMap.end()) {
-		TargetTypes = ParsedGlobalTypesMap[GV];
-		return;
-	}
+// Walk the initializer of a global for target types, types of the
+// objects holding them, fields holding declared functions or external
+// globals, and the external globals referenced
+void TyPM::parseInitializer(GlobalVariable *GV, set<Type *> &TargetTypes,
+		set<Type *> &AllocTypes, set<typeidx_t> &StoredTypeIdx,
+		vector<GlobalVariable *> &Externals) {
 
+	Constant *Ini = GV->getInitializer();
 	list<User *>LU;
 	LU.push_back(Ini);
 	set<Value *>Visited;
@@ -283,7 +296,7 @@ void TyPM::findTargetTypesInInitializer(GlobalVariable * GV,
 			// containter type for matching can improve the precision
 			TargetTypes.insert(UTy);
 			// Record allocations
-			TargetDataAllocModules[typeHash(UTy)].insert(M);
+			AllocTypes.insert(UTy);
 		}
 #endif
 		// Special handling for function pointers and external globals
@@ -294,23 +307,7 @@ void TyPM::findTargetTypesInInitializer(GlobalVariable * GV,
 					LU.push_back(GO->getInitializer());
 				}
 				else {
-					set<Type *> ExternalTypes;
-					GlobalVariable *EGV = Ctx->Globals[GO->getGUID()];
-					if (!EGV)
-						continue;
-					Module *EM = EGV->getParent();
-
-					ParsedGlobalTypesMap[GV] = ExternalTypes;
-					findTargetTypesInInitializer(EGV, 
-							EM, ExternalTypes);
-
-					for (auto Ty : ExternalTypes) {
-						size_t TyH = typeHash(Ty);
-						// Must use type hash, as Type * is specific to a module
-						// As this is in initializer, there is no load from the GV
-						moPropMap[make_pair(M, TyH)].insert(EM);
-					}
-
+					Externals.push_back(GO);
 				}
 			}
 			else if (isa<Function>(U)) {
@@ -337,12 +334,13 @@ void TyPM::findTargetTypesInInitializer(GlobalVariable * GV,
 					TargetTypes.insert(ETy);
 
 					// Record allocations
-					TargetDataAllocModules[typeHash(UTy)].insert(M);
+					AllocTypes.insert(UTy);
 
 					if (ETy->isFunctionTy()) {
 						Function *F = dyn_cast<Function>(O);
 						if (F && F->isDeclaration())
-							storedTypeIdxMap[M][UTy].insert(oi->getOperandNo());
+							StoredTypeIdx.insert(
+									make_pair(UTy, oi->getOperandNo()));
 					}
 					continue;
 				}
@@ -365,7 +363,8 @@ void TyPM::findTargetTypesInInitializer(GlobalVariable * GV,
 					// TODO
 					if (!GO->hasInitializer()) {
 						// If it is an external initializer, record it
-						storedTypeIdxMap[M][UTy].insert(oi->getOperandNo());
+						StoredTypeIdx.insert(
+								make_pair(UTy, oi->getOperandNo()));
 					}
 					LU.push_back(GO);
 					continue;
@@ -376,13 +375,61 @@ void TyPM::findTargetTypesInInitializer(GlobalVariable * GV,
 				LU.push_back(OU);
 		}
 	}
+}
+
+const TypeList &TyPM::findTargetTypesInInitializer(GlobalVariable * GV, 
+		Module *M) {
+
+	Constant *Ini = GV->getInitializer();
+	if (!Ini) return *internTypes(set<Type *>());
+	// The global can be a pointer to another global; in this case, we
+	// still need to look into it, so comment out the following line
+	//if (!isa<ConstantAggregate>(Ini)) return;
+
+	auto It = ParsedGlobalTypesMap.find(GV);
+	if (It != ParsedGlobalTypesMap.end())
+		return *It->second;
+
+	set<Type *> TargetTypes, AllocTypes;
+	set<typeidx_t> StoredTypeIdx;
+	vector<GlobalVariable *> Externals;
+	parseInitializer(GV, TargetTypes, AllocTypes, StoredTypeIdx, Externals);
+
+	for (auto Ty : AllocTypes)
+		addTargetAlloc(Ty, M);
+
+	ModuleInfo &MI = getModuleInfo(M);
+	for (auto TI : StoredTypeIdx)
+		MI.StoredTypeIdx[TI.first].insert(TI.second);
+
+	for (auto GO : Externals) {
+		GlobalVariable *EGV = Ctx->getGlobalDef(GO);
+		if (!EGV)
+			continue;
+		Module *EM = EGV->getParent();
+
+		// No types for GV while the external one is parsed
+		ParsedGlobalTypesMap[GV] = internTypes(set<Type *>());
+		const TypeList &ExternalTypes =
+			findTargetTypesInInitializer(EGV, EM);
+
+		for (auto Ty : ExternalTypes) {
+			size_t TyH = typeHash(Ty);
+			// Must use type hash, as Type * is specific to a module
+			// As this is in initializer, there is no load from the GV
+			moPropMap[make_pair(Ctx->getModuleID(M), TyH)]
+				.set(Ctx->getModuleID(EM));
+		}
+	}
 
 	// Process the type propagations
 	for (auto Ty : TargetTypes) {
 		addModuleToGVType(Ty, M, GV);
 	}
 
-	ParsedGlobalTypesMap[GV] = TargetTypes;
+	const TypeList *Types = internTypes(TargetTypes);
+	ParsedGlobalTypesMap[GV] = Types;
+	return *Types;
 }
 
 // Collect types from reads and writes against a value 
@@ -439,8 +486,7 @@ bool TyPM::parseUsesOfValue(Value *V, set<Type *> &ReadTypes,
 				Value *PO = SI->getPointerOperand();
 				// Store something to the value
 				if (PO == CV) { 
-					set<Type *>TySet;
-					findTargetTypesInValue(VO, TySet, M);
+					const TypeList &TySet = findTargetTypesInValue(VO, M);
 					for (auto FTy : TySet)
 						WrittenTypes.insert(FTy);
 				}
@@ -474,7 +520,7 @@ bool TyPM::parseUsesOfValue(Value *V, set<Type *> &ReadTypes,
 				return false;
 
 #if 0
-				for (auto CF : Ctx->Callees[CI]) {
+				for (auto CF : Ctx->getCallees(CI)) {
 					if (!CF) continue;
 					// Keep tracking if it is in the same module
 					if (CF->getParent() == M) {
@@ -492,22 +538,23 @@ bool TyPM::parseUsesOfValue(Value *V, set<Type *> &ReadTypes,
 					}
 					// Espacing case: Calling a function in another module
 					else {
-						set<Type *>TySet;
-						findTargetTypesInValue(CV, TySet, M);
+						const TypeList &TySet = findTargetTypesInValue(CV, M);
 						Module *CalleeM = CF->getParent();
 						for (auto FTy : TySet) {
 							size_t FTH = typeHash(FTy);
+							unsigned MID = Ctx->getModuleID(M);
+							unsigned CalleeMID = Ctx->getModuleID(CalleeM);
 							if (CI->isIndirectCall()) {
 								if (!CF->onlyWritesMemory())
-									moPropMapV[make_pair(CalleeM, FTH)].insert(M);
+									moPropMapV[make_pair(CalleeMID, FTH)].set(MID);
 								if (!CF->onlyReadsMemory())
-									moPropMapV[make_pair(M, FTH)].insert(CalleeM);
+									moPropMapV[make_pair(MID, FTH)].set(CalleeMID);
 							}
 							else {
 								if (!CF->onlyWritesMemory())
-									moPropMap[make_pair(CalleeM, FTH)].insert(M);
+									moPropMap[make_pair(CalleeMID, FTH)].set(MID);
 								if (!CF->onlyReadsMemory())
-									moPropMap[make_pair(M, FTH)].insert(CalleeM);
+									moPropMap[make_pair(MID, FTH)].set(CalleeMID);
 							}
 						}
 					}
@@ -552,7 +599,7 @@ void TyPM::parseUsesOfGV(GlobalVariable *GV, Value *V,
 					// Add the module of the function to map
 					addModuleToGVType(ETy, M, GV);
 #ifdef TYPE_ELEVATION
-					list<typeidx_t> TyList;
+					TypeIdxList TyList;
 					Value *NextV;
 					nextLayerBaseTypeWL(PO, TyList, NextV);
 					//set<Type *>TySet;
@@ -568,8 +615,7 @@ void TyPM::parseUsesOfGV(GlobalVariable *GV, Value *V,
 				}
 #endif
 				else {
-					set<Type *>TySet;
-					findTargetTypesInValue(VO, TySet, M);
+					const TypeList &TySet = findTargetTypesInValue(VO, M);
 					for (auto Ty : TySet) {
 						addModuleToGVType(Ty, M, GV);
 					}
@@ -578,8 +624,7 @@ void TyPM::parseUsesOfGV(GlobalVariable *GV, Value *V,
 			// The pointer is stored to else where, and we need to keep
 			// track of the new location
 			else {
-				set<Type *>TySet;
-				findTargetTypesInValue(VO, TySet, M);
+				const TypeList &TySet = findTargetTypesInValue(VO, M);
 				for (auto Ty : TySet) {
 					addModuleToGVType(Ty, M, GV);
 					addGVToModuleType(Ty, GV, M);
@@ -644,14 +689,7 @@ void TyPM::parseUsesOfGV(GlobalVariable *GV, Value *V,
 			parseUsesOfGV(GV, I, M, Visited);
 		} 
 		else if (auto *Call = dyn_cast<CallInst>(I)) {
-			GlobalVariable *EGV = Ctx->Globals[GV->getGUID()];
-			if (EGV && EGV->hasInitializer()) {
-				set<Type *>TySet;
-				findTargetTypesInInitializer(EGV, M, TySet);
-				for (auto Ty : TySet) {
-					addGVToModuleType(Ty, GV, M);
-				}
-			}
+			addGVInitializerToModule(GV, M);
 			continue;
 		} 
 		else {
@@ -695,7 +733,7 @@ void TyPM::parseTargetTypesInCalls(CallInst *CI, Function *CF) {
 				Value *CI_Arg = CI->getArgOperand(AI - CF->arg_begin()); 
 				if (Function *AF = dyn_cast<Function>(CI_Arg)) {
 					if (AF->isDeclaration())
-						AF = Ctx->GlobalFuncMap[AF->getGUID()];
+						AF = Ctx->getFuncDef(AF);
 					if (AF) {
 						addPropagation(CallerM, AF->getParent(), 
 								ETy, CI->isIndirectCall());
@@ -749,8 +787,7 @@ void TyPM::parseTargetTypesInCalls(CallInst *CI, Function *CF) {
 
 
 #if 1
-			set<Type *>TySet;
-			findTargetTypesInValue(Arg, TySet, CalleeM);
+			const TypeList &TySet = findTargetTypesInValue(Arg, CalleeM);
 			// The callee function may read
 #ifdef FLOW_DIRECTION
 			if (!CF->onlyWritesMemory()) {
@@ -822,8 +859,7 @@ void TyPM::parseTargetTypesInCalls(CallInst *CI, Function *CF) {
 			ParsedModuleTypeDCallMap[MP].insert(RTy);
 		}
 
-		set<Type *>TySet;
-		findTargetTypesInValue(CI, TySet, CallerM);
+		const TypeList &TySet = findTargetTypesInValue(CI, CallerM);
 		for (auto FTy : TySet) {
 
 #ifdef FLOW_DIRECTION
@@ -844,17 +880,16 @@ void TyPM::parseTargetTypesInCalls(CallInst *CI, Function *CF) {
 	}
 }
 
-void TyPM::findTargetTypesInValue(Value *V, 
-		set<Type *> &TargetTypes, Module *M) {
+const TypeList &TyPM::findTargetTypesInValue(Value *V, Module *M) {
 
 	Type *VTy = V->getType();
 	// Check cached results
-	if (ParsedTypeMap.find(make_pair(M, VTy)) 
-			!= ParsedTypeMap.end()) {
-		TargetTypes = ParsedTypeMap[make_pair(M, VTy)];
-		return;
-	}
+	auto It = ParsedTypeMap.find(make_pair(M, VTy));
+	if (It != ParsedTypeMap.end())
+		return *It->second;
 
+	set<Type *> TargetTypes;
+	ModuleInfo &MI = getModuleInfo(M);
 	list<Type *>LT; 
 	LT.push_back(VTy);
 	set<Type *>Visited;
@@ -884,8 +919,8 @@ void TyPM::findTargetTypesInValue(Value *V,
 
 			// Handling general pointers (void *, char *) that can
 			// also pass function pointers
-			if (PTy == Int8PtrTy[M]) {
-				TargetTypes.insert(Int8PtrTy[M]);
+			if (PTy == MI.Int8PtrTy) {
+				TargetTypes.insert(MI.Int8PtrTy);
 			}
 			else 
 				// Continue with the element type
@@ -893,10 +928,10 @@ void TyPM::findTargetTypesInValue(Value *V,
 
 			// Also track types with cast relation to it
 #if 1
-			for (auto CastTy : CastFromMap[M][Ty]) {
+			for (auto CastTy : MI.CastFrom[Ty]) {
 				LT.push_back(CastTy);
 			}
-			for (auto CastTy : CastToMap[M][Ty]) {
+			for (auto CastTy : MI.CastTo[Ty]) {
 				LT.push_back(CastTy);
 			}
 #endif
@@ -913,10 +948,9 @@ void TyPM::findTargetTypesInValue(Value *V,
 		}
 	}
 
-	ParsedTypeMap[make_pair(M, VTy)] = TargetTypes;
-	//for (auto FTy : TargetTypes) {
-	//	OP<<*FTy<<"\n";
-	//}
+	const TypeList *Types = internTypes(TargetTypes);
+	ParsedTypeMap[make_pair(M, VTy)] = Types;
+	return *Types;
 }
 
 
@@ -929,21 +963,15 @@ void TyPM::findTargetTypesInValue(Value *V,
 /////////////////////////////////////////////////////////////////////
 
 void TyPM::mapDeclToActualFuncs(FuncSet &FS) {
+	SmallVector<Function *, 16> Mapped;
 	for (auto F : FS) {
-		if (!F) {
-			FS.erase(F);
-			continue;
-		}
-		if (F->isDeclaration()) {
-			FS.erase(F);
-			F = Ctx->GlobalFuncMap[F->getGUID()];
-			if (F) {
-				FS.insert(F);
-			}
-		}
-		else
-			FS.insert(F);
+		if (F && F->isDeclaration())
+			F = Ctx->getFuncDef(F);
+		if (F)
+			Mapped.push_back(F);
 	}
+	FS.clear();
+	FS.insert(Mapped.begin(), Mapped.end());
 }
 
 void TyPM::findTargetAllocInFunction(Function * F) {
@@ -955,7 +983,7 @@ void TyPM::findTargetAllocInFunction(Function * F) {
 		if (AllocaInst *AI = dyn_cast<AllocaInst>(I)) {
 			Type *Ty = AI->getAllocatedType();
 			if (isTargetTy(Ty)) {
-				TargetDataAllocModules[typeHash(Ty)].insert(F->getParent());
+				addTargetAlloc(Ty, F->getParent());
 			}
 		}
 	}
@@ -967,28 +995,32 @@ void TyPM::findTargetAllocInFunction(Function * F) {
 // "externality analysis" of the type elevation
 void TyPM::findStoredTypeIdxInFunction(Function * F) {
 
+	ModuleInfo &MI = getModuleInfo(F->getParent());
+
 	for (inst_iterator i = inst_begin(F), e = inst_end(F); 
 			i != e; ++i) {
 		Instruction *I = &*i;
 
 		if (StoreInst *SI = dyn_cast<StoreInst>(I)) {
 
-			StoreInstSet.insert(SI);
+#ifndef FUNCTION_AS_TARGET_TYPE
+			recordStore(SI, MI);
+#endif
 
 			Value *PO = SI->getPointerOperand();
 
-			list<typeidx_t> TyList;
+			TypeIdxList TyList;
 			Value *NextV;
 			nextLayerBaseTypeWL(PO, TyList, NextV);
 			if (!TyList.empty()) {
 				typeidx_t TI = TyList.front();
-				storedTypeIdxMap[F->getParent()][TI.first].insert(TI.second);
+				MI.StoredTypeIdx[TI.first].insert(TI.second);
 				continue;
 			}
 			set<Value *>Visited;
 			Type *BTy = getBaseType(PO, Visited);
 			if (BTy) {
-				storedTypeIdxMap[F->getParent()][BTy].insert(0);
+				MI.StoredTypeIdx[BTy].insert(0);
 				continue;
 			}
 		}
@@ -1003,13 +1035,13 @@ void TyPM::findStoredTypeIdxInFunction(Function * F) {
 //
 /////////////////////////////////////////////////////////////////////
 
-void TyPM::getDependentModulesV(Value* TV, Module *M,
-		set<Module *> &MSet) {
+const ModuleSet &TyPM::getDependentModulesV(Value* TV, unsigned MID) {
 
 	Type *Ty = TV->getType();
+	auto &StoredTypeIdx = getModuleInfo(MID).StoredTypeIdx;
 
 	// Get the outermost layer type
-	list<typeidx_t> TyList;
+	TypeIdxList TyList;
 	Value *CV = TV, *NextV;
 	set<Value*> Visited;
 	while (nextLayerBaseTypeWL(CV, TyList, NextV)) {
@@ -1039,10 +1071,9 @@ void TyPM::getDependentModulesV(Value* TV, Module *M,
 		// negatives
 		//
 		// Externality check
-		if (storedTypeIdxMap[M].find(TyIdx.first) 
-				!= storedTypeIdxMap[M].end()) {
-			if ((storedTypeIdxMap[M][TyIdx.first].find(TyIdx.second)
-						!= storedTypeIdxMap[M][TyIdx.first].end())
+		auto It = StoredTypeIdx.find(TyIdx.first);
+		if (It != StoredTypeIdx.end()) {
+			if ((It->second.find(TyIdx.second) != It->second.end())
 					|| TyIdx.second == -1)
 				break;
 		}
@@ -1067,58 +1098,32 @@ void TyPM::getDependentModulesV(Value* TV, Module *M,
 			TTy = TTy->getPointerElementType();
 	}
 
-	auto TyM = make_pair(M, typeHash(TTy));
-	if (ResolvedDepModulesMap.find(TyM)
-			!= ResolvedDepModulesMap.end())
-		MSet = ResolvedDepModulesMap[TyM];
-	else {
-		getDependentModulesTy(typeHash(TTy), M, MSet);
-		ResolvedDepModulesMap[TyM] = MSet;
-	}
-	if (MSet.size() == 0 && isContainerTy(TTy)) {
-		if (storedTypeIdxMap[M].find(TTy) == storedTypeIdxMap[M].end()) {
-			set<Module *> &MSet = TargetDataAllocModules[typeHash(TTy)];
-			if (MSet.find(M) == MSet.end()) {
+	const ModuleSet &MSet = getDependentModulesTy(typeHash(TTy), MID);
+	if (MSet.empty() && isContainerTy(TTy)) {
+		if (StoredTypeIdx.find(TTy) == StoredTypeIdx.end()) {
+			ModuleSet &AMSet = TargetDataAllocModules[typeHash(TTy)];
+			if (!AMSet.test(MID)) {
 				OP<<"!!! NO DEPENDENCE: "<<*TTy<<"\n";
 				printSourceCodeInfo(TV, "TYPE-ERR");
 			}
 		}
 	}
+	return MSet;
 }
 
 
-void TyPM::getDependentModulesTy(size_t TyH, Module *M,
-		set<Module *> &MSet) {
-
-	//
-	// Resolving dependent modules for M
-	//
-
-	set<Module *> PM;
-	list<Module *> EM;
-	EM.push_back(M);
-
-	while (!EM.empty()) {
-		Module *TM = EM.front();
-		EM.pop_front();
-		// To test the presence of an element - find() in set, count() in multiset
-		if (PM.find(TM) != PM.end())
-			continue;
-		PM.insert(TM);
-
-		for (auto m : moPropMapAll[make_pair(TM, TyH)]) {
-			MSet.insert(m);
-			EM.push_back(m);
-		}
+const ModuleSet &TyPM::getDependentModulesTy(size_t TyH, unsigned MID) {
+	return DepModules.get(TyH, MID);
+}
 
-		// Handling transitioning modules that can pass function
-		// poitners, although there is no function type
-		for (auto m : moPropMapAll[make_pair(TM, typeHash(Int8PtrTy[TM]))]) {
-			// Simply continue to search related modules
-			EM.push_back(m);
-		}
+void TyPM::buildDependentModules() {
 
-	}
+	// Modules also pass facts through general pointers, see
+	// ModuleClosure
+	vector<size_t> HubTypes;
+	for (unsigned MID = 0; MID < Ctx->Modules.size(); ++MID)
+		HubTypes.push_back(typeHash(getModuleInfo(MID).Int8PtrTy));
+	DepModules.build(moPropMapAll, HubTypes);
 }
 
 bool TyPM::resolveFunctionTargets() {
@@ -1128,46 +1133,47 @@ bool TyPM::resolveFunctionTargets() {
 
 	for (auto CI : ICallSet) {
 
-		oldCount += Ctx->Callees[CI].size();
+		// Prune a copy; the set is shared with other callsites
+		FuncSet Callees = Ctx->getCallees(CI);
+		oldCount += Callees.size();
 		oldModuleCount += Ctx->Modules.size();
-		Module *CallerM = CI->getModule();
 		CallBase *CB = dyn_cast<CallBase>(CI);
 		Type *FuncType = CB->getFunctionType(); 
-		set<Module *> MSet;
-		getDependentModulesV(CI->getCalledOperand(), CallerM, MSet); 
-		MSet.insert(CallerM);
-		newModuleCount += MSet.size();
+		// The caller module counts as a dependent module
+		unsigned CallerMID = Ctx->getModuleID(CI->getModule());
+		const ModuleSet &MSet =
+			getDependentModulesV(CI->getCalledOperand(), CallerMID);
+		newModuleCount += MSet.count() + !MSet.test(CallerMID);
 
 #ifdef PRINT_ICALL_TARGET
 		printSourceCodeInfo(CI, "RESOLVING");
 #endif
-		for (auto Callee : Ctx->Callees[CI]) {
-			Module *CalleeM = Callee->getParent();
-			if (MSet.find(CalleeM) != MSet.end()) {
+		Callees.removeIDsIf([&](uint32_t CalleeID) {
+			unsigned CalleeMID = Ctx->getFuncModuleID(CalleeID);
+			if (CalleeMID == CallerMID || MSet.test(CalleeMID)) {
 				newCount += 1;
+				return false;
 			}
-			else {
-				// Do not remove out-of-analysis-scope functions which
-				// can still be valid targets
-				string FN = Callee->getName().str();
-				if ((OutScopeFuncNames.find(FN) 
-							== OutScopeFuncNames.end())
-						//&& (StoredFuncs.find(Callee) != StoredFuncs.end())
-				   ) {
-
-					Ctx->Callees[CI].erase(Callee);
+			Function *Callee = FuncIDMap::get(CalleeID);
+			// Do not remove out-of-analysis-scope functions which
+			// can still be valid targets
+			string FN = Callee->getName().str();
+			if ((OutScopeFuncNames.find(FN) 
+						== OutScopeFuncNames.end())
+					//&& (StoredFuncs.find(Callee) != StoredFuncs.end())
+			   ) {
 #ifdef PRINT_ICALL_TARGET
-					printSourceCodeInfo(Callee, "REMOVED");
+				printSourceCodeInfo(Callee, "REMOVED");
 #endif
-				}
-				else { 
-					outScopeCount += 1;
-				}
+				return true;
 			}
-		}
-		mapDeclToActualFuncs(Ctx->Callees[CI]);
+			outScopeCount += 1;
+			return false;
+		});
+		mapDeclToActualFuncs(Callees);
+		Ctx->setCallees(CI, Callees);
 #ifdef PRINT_ICALL_TARGET
-		printTargets(Ctx->Callees[CI], CI);
+		printTargets(Callees, CI);
 #endif
 	}
 	if (Ctx->NumIndirectCallTargets > 0) {
@@ -1193,104 +1199,128 @@ bool TyPM::resolveFunctionTargets() {
 	return true;
 }
 
-bool TyPM::resolveStructTargets() {
+// Find the outermost target type written by the store, and keep the
+// store for resolveStructTargets() if it may write a critical data
+// structure. The types do not change over the iterations, so this is
+// done once, in the initialization.
+void TyPM::recordStore(StoreInst *SI, ModuleInfo &MI) {
 
-	uint64_t oldCount = 0, newCount = 0, totalCount = 0;
-	int criticalWrites = 0;
+	++NumStores;
 
-	int Progress = 0;
-	for (auto SI : StoreInstSet) {
-		++Progress;
-
-		bool criticalType = false;
-		Value *PO = SI->getPointerOperand();
-		list<typeidx_t> TyList;
-		Value *CV = PO, *NextV;
-		set<Value*> Visited;
-		while (nextLayerBaseTypeWL(CV, TyList, NextV)) {
-			Visited.insert(CV);
-			if (Visited.find(NextV) != Visited.end()) {
-				break;
-			}
-			CV = NextV;
+	bool criticalType = false;
+	Value *PO = SI->getPointerOperand();
+	TypeIdxList TyList;
+	Value *CV = PO, *NextV;
+	set<Value*> Visited;
+	while (nextLayerBaseTypeWL(CV, TyList, NextV)) {
+		Visited.insert(CV);
+		if (Visited.find(NextV) != Visited.end()) {
+			break;
 		}
-		Type *TTy = NULL;
-		for (auto TyIdx : TyList) {
-			if (isTargetTy(TyIdx.first)) {
-				TTy = TyIdx.first;
-				criticalType = true;
-				break;
-			}
+		CV = NextV;
+	}
+	Type *TTy = NULL;
+	int Idx = 0;
+	for (auto TyIdx : TyList) {
+		if (isTargetTy(TyIdx.first)) {
+			TTy = TyIdx.first;
+			Idx = TyIdx.second;
+			criticalType = true;
+			break;
 		}
-		if (!TTy) {
-			set<Value *>Visited;
-			TTy = getBaseType(PO, Visited);
-			if (TTy && isTargetTy(TTy)) {
-				criticalType = true;
-			}
+	}
+	if (!TTy) {
+		set<Value *>Visited;
+		TTy = getBaseType(PO, Visited);
+		if (TTy && isTargetTy(TTy)) {
+			criticalType = true;
 		}
-		if ((PO->getType() != Int8PtrTy[SI->getModule()]) 
-				&& !criticalType)
-			continue;
+	}
+	if ((PO->getType() != MI.Int8PtrTy) && !criticalType)
+		return;
 
-		// the remaining writes target either critical structures or
-		// general pointers.
-		// now, further resolve the dependences for them
+	StoreRecord SR;
+	SR.TTy = TTy;
+	SR.Idx = Idx;
+	SR.Critical = criticalType;
+	MI.Stores.push_back(SR);
+}
 
-		if (criticalType) {
+bool TyPM::resolveStructTargets() {
+
+	uint64_t oldCount = 0, newCount = 0, totalCount = 0;
+	int criticalWrites = 0;
 
-			totalCount += Ctx->Modules.size();
+	uint64_t NumRecords = 0;
+	for (unsigned MID = 0; MID < Ctx->Modules.size(); ++MID)
+		NumRecords += getModuleInfo(MID).Stores.size();
 
-			size_t TyH = typeHash(TTy);
+	uint64_t Progress = 0;
+	for (unsigned MID = 0; MID < Ctx->Modules.size(); ++MID) {
+		for (const StoreRecord &SR : getModuleInfo(MID).Stores) {
+			++Progress;
 
-			// Resolving dependences for TTy
-			set<Module *>MSet;
-			getDependentModulesTy(TyH, SI->getModule(), MSet);
-			if (MSet.size() == 0)
-				continue;
-			for (auto tyh : TargetDataAllocModules[TyH]) {
-				++oldCount;
-				// Matched
-				if (MSet.find(tyh) != MSet.end()) {
-					++newCount;
-				}
-			}
-		}
+			bool criticalType = SR.Critical;
+			Type *TTy = SR.TTy;
+
+			// the recorded writes target either critical structures or
+			// general pointers.
+			// now, further resolve the dependences for them
+
+			if (criticalType) {
+
+				totalCount += Ctx->Modules.size();
+
+				size_t TyH = typeHash(TTy);
 
-		// the following assumes that general pointer may also target
-		// critical data structures and goes ahead to resove
-		// dependences
-#if 0
-		else {
-			totalCount += Ctx->Modules.size();
-			for (size_t TyH : TTySet) {
 				// Resolving dependences for TTy
-				set<Module *>MSet;
-				getDependentModules(TyH, SI->getModule(), MSet);
-				if (MSet.size() == 0)
+				const ModuleSet &MSet = getDependentModulesTy(TyH, MID);
+				if (MSet.empty())
 					continue;
 				for (auto tyh : TargetDataAllocModules[TyH]) {
 					++oldCount;
 					// Matched
-					if (MSet.find(tyh) != MSet.end()) {
+					if (MSet.test(tyh)) {
 						++newCount;
-						criticalType = true;
 					}
 				}
-				if (criticalType)
-					break;
 			}
-		}
+
+			// the following assumes that general pointer may also target
+			// critical data structures and goes ahead to resove
+			// dependences
+#if 0
+			else {
+				totalCount += Ctx->Modules.size();
+				for (size_t TyH : TTySet) {
+					// Resolving dependences for TTy
+					set<Module *>MSet;
+					getDependentModules(TyH, M, MSet);
+					if (MSet.size() == 0)
+						continue;
+					for (auto tyh : TargetDataAllocModules[TyH]) {
+						++oldCount;
+						// Matched
+						if (MSet.find(tyh) != MSet.end()) {
+							++newCount;
+							criticalType = true;
+						}
+					}
+					if (criticalType)
+						break;
+				}
+			}
 #endif
-		if (criticalType)
-			++criticalWrites;
+			if (criticalType)
+				++criticalWrites;
 
-		OP<<Progress<<" / "<<StoreInstSet.size()<<"\n";
+			OP<<Progress<<" / "<<NumRecords<<"\n";
+		}
 	}
 
 	time_t my_time = time(NULL);
 	OP<<"# TIME: "<<ctime(&my_time)<<"\n";
-	cout<<"@@ Total stores: "<<StoreInstSet.size()<<"\n";
+	cout<<"@@ Total stores: "<<NumStores<<"\n";
 	cout<<"@@ Critical stores: "<<criticalWrites<<"\n";
 	cout<<"\n@@ Target Reduction: "
 		<<newCount<<"/"<<oldCount<<"/"<<totalCount<<", Reduction Rate: "
@@ -3,8 +3,11 @@
 
 #include "Analyzer.h"
 #include "MLTA.h"
+#include "ModuleClosure.h"
 #include "Config.h"
 
+// Target types found in a value or an initializer, in pointer order
+typedef vector<Type *, ArenaAllocator<Type *, RunArena>> TypeList;
 
 class TyPM : public MLTA {
 
@@ -15,10 +18,10 @@ class TyPM : public MLTA {
 		// 
 
 		//GlobalContext *Ctx;
-		set<CallInst *>CallSet;
 		set<CallInst *>ICallSet;
 		set<CallInst *>MatchedICallSet;
-		set<StoreInst *>StoreInstSet;
+		// Number of stores, see ModuleInfo::Stores
+		uint64_t NumStores = 0;
 
 
 		//
@@ -27,37 +30,35 @@ class TyPM : public MLTA {
 
 		// Set of target types
 		set<size_t>TTySet;
-		DenseMap<size_t, set<Module *>> TargetDataAllocModules;
+		DenseMap<size_t, ModuleSet> TargetDataAllocModules;
 
 		set<string> OutScopeFuncNames;
 
-		// Propagation maps
+		// Propagation maps, keyed by module ID and type hash
 		DenseMap<Module*, set<map<Module*, set<size_t>>>>moTyPropMap;
-		DenseMap<pair<Module*, size_t>, set<Module*>>moPropMap;
+		DenseMap<pair<unsigned, size_t>, ModuleSet>moPropMap;
 		// Versatile map for refined indirect calls
-		DenseMap<pair<Module*, size_t>, set<Module*>>moPropMapV;
-
-		// Which fields of a type have been stored to
-		DenseMap<Module *, map<Type *, set<int>>> storedTypeIdxMap;
-
-		// All casts in a module
-		DenseMap<Module *, map<Type *, set<Type *>>> CastFromMap;
-		DenseMap<Module *, map<Type *, set<Type *>>> CastToMap;
+		DenseMap<pair<unsigned, size_t>, ModuleSet>moPropMapV;
 
 		// Function types that can be held by the GV
 		DenseMap<GlobalVariable *, set<Type *>>GVFuncTypesMap;
 		// Modules that store function pointers of the type to the global
-		DenseMap<pair<uint64_t, size_t>, set<Module *>>TypesFromModuleGVMap;
+		DenseMap<pair<uint64_t, size_t>, ModuleSet>TypesFromModuleGVMap;
 		// Modules that load function pointers of the type from the global
-		DenseMap<pair<uint64_t, size_t>, set<Module *>>TypesToModuleGVMap;
+		DenseMap<pair<uint64_t, size_t>, ModuleSet>TypesToModuleGVMap;
 
-		// For caching
-		DenseMap<size_t, FuncSet> MatchedICallTypeMap;
-		DenseMap<pair<Module *, size_t>, set<Module *>> ResolvedDepModulesMap;
-		DenseMap<pair<Module *, Type *>, set<Type *>>ParsedTypeMap;
-		DenseMap<GlobalVariable *, set<Type *>>ParsedGlobalTypesMap;
-		DenseMap<pair<Module *, Module *>, set<Type *>>ParsedModuleTypeICallMap;
-		DenseMap<pair<Module *, Module *>, set<Type *>>ParsedModuleTypeDCallMap;
+		// For caching. Cached results are returned by reference, so
+		// they must not move: type lists are interned in TypeLists,
+		// and the dependent modules are kept by DepModules.
+		DenseMap<size_t, const FuncSet *> MatchedICallTypeMap;
+		ModuleClosure DepModules;
+		ArenaSet<TypeList, RunArena> TypeLists;
+		DenseMap<pair<Module *, Type *>, const TypeList *>ParsedTypeMap;
+		DenseMap<GlobalVariable *, const TypeList *>ParsedGlobalTypesMap;
+		DenseMap<pair<Module *, Module *>, ArenaSet<Type *, PhaseArena>>
+			ParsedModuleTypeICallMap;
+		DenseMap<pair<Module *, Module *>, ArenaSet<Type *, PhaseArena>>
+			ParsedModuleTypeDCallMap;
 
 
 
@@ -74,9 +75,11 @@ class TyPM : public MLTA {
 		// API for getting dependent modules based on the target type
 		bool resolveFunctionTargets();
 		bool resolveStructTargets();
-		void getDependentModulesTy(size_t TyH, Module *M, set<Module *>&MSet);
+		const ModuleSet &getDependentModulesTy(size_t TyH, unsigned MID);
+		// Set up DepModules once moPropMapAll is complete for a phase
+		void buildDependentModules();
 		// API for getting dependent modules based on the target value
-		void getDependentModulesV(Value *TV,	Module *M, set<Module *>&MSet);
+		const ModuleSet &getDependentModulesV(Value *TV, unsigned MID);
 
 
 		// Typecasting analysis
@@ -88,14 +91,17 @@ class TyPM : public MLTA {
 		
 		// Analyze globals and function calls for potential types of
 		// data flows
-		void findTargetTypesInInitializer(GlobalVariable *, Module *, 
-				set<Type *> &TargetTypes);
+		void parseInitializer(GlobalVariable *GV, set<Type *> &TargetTypes,
+				set<Type *> &AllocTypes, set<typeidx_t> &StoredTypeIdx,
+				vector<GlobalVariable *> &Externals);
+		const TypeList &findTargetTypesInInitializer(GlobalVariable *,
+				Module *);
 		void parseUsesOfGV(GlobalVariable *GV, Value *, 
 				Module *, set<Value *> &Visited);
 		bool parseUsesOfValue(Value *V, set<Type *> &ReadTypes, 
 				set<Type *> &WrittenTypes, Module *M);
-		void findTargetTypesInValue(Value *V, 
-				set<Type *> &TargetTypes, Module *M);
+		const TypeList &findTargetTypesInValue(Value *V, Module *M);
+		const TypeList *internTypes(const set<Type *> &Types);
 		void parseTargetTypesInCalls(CallInst *CI, Function *CF);
 
 
@@ -103,21 +109,29 @@ class TyPM : public MLTA {
 		// mapping between modules, through calls
 		void addPropagation(Module *ToM, Module *FromM, Type *Ty, 
 				bool isICall = false);
-		// mapping between module and global, through globals
-		void addModuleToGVType(Type *Ty, Module *M, GlobalVariable *GV);
-		void addGVToModuleType(Type *Ty, GlobalVariable *GV, Module *M);
+		// mapping between module and global, through globals; like
+		// the facts of MLTA, SummaryBuilder records these instead
+		virtual void addModuleToGVType(Type *Ty, Module *M,
+				GlobalVariable *GV);
+		virtual void addGVToModuleType(Type *Ty, GlobalVariable *GV,
+				Module *M);
+		virtual void addGVInitializerToModule(GlobalVariable *GV,
+				Module *M);
+		// allocations of target types
+		virtual void addTargetAlloc(Type *Ty, Module *M);
 
 
 
 		// Parse functions for various semantic information
 		void findStoredTypeIdxInFunction(Function * F);
+		void recordStore(StoreInst *SI, ModuleInfo &MI);
 		void findTargetAllocInFunction(Function * F);
 		void mapDeclToActualFuncs(FuncSet &FS);
 
 	public:
 
 		// Merged map
-		static DenseMap<pair<Module*, size_t>, set<Module*>>moPropMapAll;
+		static DenseMap<pair<unsigned, size_t>, ModuleSet>moPropMapAll;
 
 		TyPM(GlobalContext *Ctx_) : MLTA(Ctx_) {
 			LoadTargetTypes(TTySet);
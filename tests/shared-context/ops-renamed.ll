@@ -0,0 +1,18 @@
+; Defines struct.ops, as ops.ll does, so the shared context renames it
+; here. It must still be the type of ops.ll: call_c may call fa and fd,
+; and call_a may call fd as well.
+
+%struct.ops = type { void (i32)* }
+
+@c_ops = global %struct.ops { void (i32)* @fd }
+
+define void @fd(i32 %x) {
+  ret void
+}
+
+define void @call_c(%struct.ops* %p) {
+  %f = getelementptr %struct.ops, %struct.ops* %p, i32 0, i32 0
+  %fp = load void (i32)*, void (i32)** %f
+  call void %fp(i32 1)
+  ret void
+}
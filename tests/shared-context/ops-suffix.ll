@@ -0,0 +1,49 @@
+; Defines struct.ops.7 and struct.ops.10, whose names only look like
+; renames of struct.ops. Their suffixes are in the range the shared
+; context assigns to the renamed s1 to s12, so they must not be
+; mistaken for struct.ops: call_b may only call fb.
+
+%struct.ops.7 = type { void (i32)* }
+%struct.ops.10 = type { void (i64)* }
+%struct.s1 = type { i16 }
+%struct.s2 = type { i24 }
+%struct.s3 = type { i32 }
+%struct.s4 = type { i8 }
+%struct.s5 = type { i16 }
+%struct.s6 = type { i24 }
+%struct.s7 = type { i32 }
+%struct.s8 = type { i8 }
+%struct.s9 = type { i16 }
+%struct.s10 = type { i24 }
+%struct.s11 = type { i32 }
+%struct.s12 = type { i8 }
+
+@b_s1 = global %struct.s1 zeroinitializer
+@b_s2 = global %struct.s2 zeroinitializer
+@b_s3 = global %struct.s3 zeroinitializer
+@b_s4 = global %struct.s4 zeroinitializer
+@b_s5 = global %struct.s5 zeroinitializer
+@b_s6 = global %struct.s6 zeroinitializer
+@b_s7 = global %struct.s7 zeroinitializer
+@b_s8 = global %struct.s8 zeroinitializer
+@b_s9 = global %struct.s9 zeroinitializer
+@b_s10 = global %struct.s10 zeroinitializer
+@b_s11 = global %struct.s11 zeroinitializer
+@b_s12 = global %struct.s12 zeroinitializer
+@b_ops = global %struct.ops.7 { void (i32)* @fb }
+@b_ops10 = global %struct.ops.10 { void (i64)* @fc }
+
+define void @fb(i32 %x) {
+  ret void
+}
+
+define void @fc(i64 %x) {
+  ret void
+}
+
+define void @call_b(%struct.ops.7* %p) {
+  %f = getelementptr %struct.ops.7, %struct.ops.7* %p, i32 0, i32 0
+  %fp = load void (i32)*, void (i32)** %f
+  call void %fp(i32 1)
+  ret void
+}
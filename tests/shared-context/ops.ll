@@ -0,0 +1,41 @@
+; Defines struct.ops. The structs s1 to s12 are defined by
+; ops-suffix.ll as well, so the shared context renames them there.
+
+%struct.ops = type { void (i32)* }
+%struct.s1 = type { i16 }
+%struct.s2 = type { i24 }
+%struct.s3 = type { i32 }
+%struct.s4 = type { i8 }
+%struct.s5 = type { i16 }
+%struct.s6 = type { i24 }
+%struct.s7 = type { i32 }
+%struct.s8 = type { i8 }
+%struct.s9 = type { i16 }
+%struct.s10 = type { i24 }
+%struct.s11 = type { i32 }
+%struct.s12 = type { i8 }
+
+@a_s1 = global %struct.s1 zeroinitializer
+@a_s2 = global %struct.s2 zeroinitializer
+@a_s3 = global %struct.s3 zeroinitializer
+@a_s4 = global %struct.s4 zeroinitializer
+@a_s5 = global %struct.s5 zeroinitializer
+@a_s6 = global %struct.s6 zeroinitializer
+@a_s7 = global %struct.s7 zeroinitializer
+@a_s8 = global %struct.s8 zeroinitializer
+@a_s9 = global %struct.s9 zeroinitializer
+@a_s10 = global %struct.s10 zeroinitializer
+@a_s11 = global %struct.s11 zeroinitializer
+@a_s12 = global %struct.s12 zeroinitializer
+@a_ops = global %struct.ops { void (i32)* @fa }
+
+define void @fa(i32 %x) {
+  ret void
+}
+
+define void @call_a(%struct.ops* %p) {
+  %f = getelementptr %struct.ops, %struct.ops* %p, i32 0, i32 0
+  %fp = load void (i32)*, void (i32)** %f
+  call void %fp(i32 1)
+  ret void
+}
@@ -0,0 +1,36 @@
+#!/bin/bash
+#
+# Check that --shared-context does not change the call graph when
+# structs are renamed by the shared LLVMContext, or have names that
+# merely look renamed.
+#
+# Usage: run.sh <path to kanalyzer>
+
+KANALYZER=${1:-../../build/lib/kanalyzer}
+LLVM_AS=${LLVM_AS:-llvm-as}
+DIR=$(cd $(dirname $0) && pwd)
+TMP=$(mktemp -d)
+trap "rm -rf $TMP" EXIT
+
+for f in ops ops-suffix ops-renamed; do
+	$LLVM_AS $DIR/$f.ll -o $TMP/$f.bc || exit 1
+done
+
+# The statistics of the call graph, without timing and printed types,
+# whose names differ in the shared context
+stats() {
+	$KANALYZER "$@" $TMP/ops.bc $TMP/ops-suffix.bc $TMP/ops-renamed.bc 2>&1 \
+		| grep -E "^(#|@@) " | grep -v -i "time\|memory" | grep -v "%"
+}
+
+RET=0
+for m in 1 2; do
+	stats -mlta=$m > $TMP/default.txt
+	stats -mlta=$m --shared-context > $TMP/shared.txt
+	if ! diff $TMP/default.txt $TMP/shared.txt; then
+		echo "FAIL: -mlta=$m --shared-context"
+		RET=1
+	fi
+done
+[ $RET -eq 0 ] && echo "PASS"
+exit $RET
@@ -0,0 +1,43 @@
+; Defines register_handler, which confines the functions passed to it
+; to the field of struct.handler, and calls through the field and
+; through the ops of dev_a, a global of ops.ll.
+
+%struct.handler = type { void (i16)*, i32 }
+%struct.ops = type { void (i32)*, void (i64)*, i8* }
+%struct.dev = type { %struct.ops*, i32 }
+
+@handler = global %struct.handler zeroinitializer
+@dev_a = external global %struct.dev
+@shared_buf = external global i8*
+
+define void @register_handler(void (i16)* %h) {
+  %f = getelementptr %struct.handler, %struct.handler* @handler, i32 0, i32 0
+  store void (i16)* %h, void (i16)** %f
+  ret void
+}
+
+define void @hc(i16 %x) {
+  ret void
+}
+
+define void @call_handler(i16 %x) {
+  %f = getelementptr %struct.handler, %struct.handler* @handler, i32 0, i32 0
+  %fp = load void (i16)*, void (i16)** %f
+  call void %fp(i16 %x)
+  ret void
+}
+
+define void @call_dev(i32 %x) {
+  %po = getelementptr %struct.dev, %struct.dev* @dev_a, i32 0, i32 0
+  %o = load %struct.ops*, %struct.ops** %po
+  %f = getelementptr %struct.ops, %struct.ops* %o, i32 0, i32 0
+  %fp = load void (i32)*, void (i32)** %f
+  call void %fp(i32 %x)
+  ret void
+}
+
+define i8* @get_buf() {
+  %b = load i8*, i8** @shared_buf
+  ret i8* %b
+}
+
@@ -0,0 +1,67 @@
+; Defines the ops tables. The handlers are confined to the fields of
+; struct.ops by the initializer of ops_a, by a store in init_ops, and
+; through register_handler, which is declared here and defined in
+; handler.ll.
+
+%struct.ops = type { void (i32)*, void (i64)*, i8* }
+%struct.dev = type { %struct.ops*, i32 }
+
+@ops_a = global %struct.ops { void (i32)* @fa, void (i64)* @ga, i8* null }
+@ops_b = global %struct.ops zeroinitializer
+@dev_a = global %struct.dev { %struct.ops* @ops_a, i32 0 }
+@shared_buf = global i8* null
+
+declare void @register_handler(void (i16)*)
+
+define void @fa(i32 %x) {
+  ret void
+}
+
+define void @fb(i32 %x) {
+  ret void
+}
+
+define void @ga(i64 %x) {
+  ret void
+}
+
+define void @ha(i16 %x) {
+  ret void
+}
+
+define void @init_ops() {
+  %f = getelementptr %struct.ops, %struct.ops* @ops_b, i32 0, i32 0
+  store void (i32)* @fb, void (i32)** %f
+  call void @register_handler(void (i16)* @ha)
+  ret void
+}
+
+; Propagates the ops of one device to another
+define void @copy_ops(%struct.dev* %to, %struct.dev* %from) {
+  %pf = getelementptr %struct.dev, %struct.dev* %from, i32 0, i32 0
+  %o = load %struct.ops*, %struct.ops** %pf
+  %pt = getelementptr %struct.dev, %struct.dev* %to, i32 0, i32 0
+  store %struct.ops* %o, %struct.ops** %pt
+  ret void
+}
+
+; Escapes the third field
+define void @set_priv(%struct.ops* %o, i8* %p) {
+  %f = getelementptr %struct.ops, %struct.ops* %o, i32 0, i32 2
+  store i8* %p, i8** %f
+  store i8* %p, i8** @shared_buf
+  ret void
+}
+
+define void @call_ops(%struct.dev* %d, i32 %x) {
+  %po = getelementptr %struct.dev, %struct.dev* %d, i32 0, i32 0
+  %o = load %struct.ops*, %struct.ops** %po
+  %f = getelementptr %struct.ops, %struct.ops* %o, i32 0, i32 0
+  %fp = load void (i32)*, void (i32)** %f
+  call void %fp(i32 %x)
+  %g = getelementptr %struct.ops, %struct.ops* %o, i32 0, i32 1
+  %gp = load void (i64)*, void (i64)** %g
+  call void %gp(i64 0)
+  ret void
+}
+
@@ -0,0 +1,44 @@
+#!/bin/bash
+#
+# Check that the call graph built from module summaries, with
+# --max-resident-modules or --emit-summary and --from-summaries, is the
+# one built from the modules.
+#
+# Usage: run.sh <path to kanalyzer>
+
+KANALYZER=${1:-../../build/lib/kanalyzer}
+LLVM_AS=${LLVM_AS:-llvm-as}
+DIR=$(cd $(dirname $0) && pwd)
+TMP=$(mktemp -d)
+trap "rm -rf $TMP" EXIT
+
+FILES=""
+for f in ops handler user; do
+	$LLVM_AS $DIR/$f.ll -o $TMP/$f.bc || exit 1
+	FILES="$FILES $TMP/$f.bc"
+done
+
+# The statistics of the call graph, without timing
+stats() {
+	$KANALYZER "$@" 2>&1 | grep -E "^(#|@@) " | grep -v -i "time\|memory"
+}
+
+RET=0
+for m in 0 1 2; do
+	stats -mlta=$m $FILES > $TMP/modules.txt
+	stats -mlta=$m --max-resident-modules=1 $FILES > $TMP/resident.txt
+	rm -rf $TMP/summaries
+	$KANALYZER -mlta=$m --emit-summary=$TMP/summaries $FILES \
+		> /dev/null 2>&1 || exit 1
+	stats -mlta=$m --from-summaries \
+		$(cat $TMP/summaries/summaries.list) > $TMP/summaries.txt
+
+	for mode in resident summaries; do
+		if ! diff $TMP/modules.txt $TMP/$mode.txt; then
+			echo "FAIL: -mlta=$m, $mode"
+			RET=1
+		fi
+	done
+done
+[ $RET -eq 0 ] && echo "PASS"
+exit $RET
@@ -0,0 +1,41 @@
+; Calls functions of the other modules with function pointers and
+; through a plain function pointer, which only the types of the args
+; confine. hd is address-taken but never stored to a struct.
+
+%struct.ops = type { void (i32)*, void (i64)*, i8* }
+%struct.dev = type { %struct.ops*, i32 }
+
+@fp_table = global [2 x void (i32)*] [void (i32)* @hd, void (i32)* @hf]
+@dev_u = global %struct.dev zeroinitializer
+
+declare void @copy_ops(%struct.dev*, %struct.dev*)
+declare void @call_ops(%struct.dev*, i32)
+declare void @register_handler(void (i16)*)
+declare i8* @get_buf()
+
+define void @hd(i32 %x) {
+  ret void
+}
+
+define void @he(i16 %x) {
+  ret void
+}
+
+define void @hf(i32 %x) {
+  ret void
+}
+
+define void @use(%struct.dev* %d, void (i32)* %cb) {
+  call void @copy_ops(%struct.dev* @dev_u, %struct.dev* %d)
+  call void @call_ops(%struct.dev* @dev_u, i32 1)
+  call void @register_handler(void (i16)* @he)
+  call void %cb(i32 2)
+  %b = call i8* @get_buf()
+  %c = bitcast i8* %b to void (i32)*
+  call void %c(i32 3)
+  %t = getelementptr [2 x void (i32)*], [2 x void (i32)*]* @fp_table, i32 0, i32 1
+  %tp = load void (i32)*, void (i32)** %t
+  call void %tp(i32 4)
+  ret void
+}
+